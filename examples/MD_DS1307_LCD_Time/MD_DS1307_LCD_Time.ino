@@ -6,11 +6,7 @@
 #include <MD_DS1307.h>
 #include <Wire.h>
 
-#ifdef ARDUINO_ARCH_SAMD
 MD_DS1307 myRTC;  ///< Locally created instance of the RTC class
-#else
-#define myRTC RTC ///< Library created instance of the RTC class
-#endif
 
 LiquidCrystal lcd(8, 9, 4, 5, 6, 7);
 
@@ -21,8 +17,11 @@ void setup()
   lcd.clear();
   lcd.noCursor();
 
-  // Ensure the clock is running
-  if (!myRTC.isRunning())
+  // status() is checked on every display update, so keep it in memory
+  myRTC.enableCache();
+
+  // Start the RTC and ensure the clock is running
+  if (myRTC.begin() & DS1307_BOOT_HALTED)
     myRTC.control(DS1307_CLOCK_HALT, DS1307_OFF);
 }
 
@@ -41,30 +40,72 @@ const char *dow2String(uint8_t code)
   return(str[code]);
 }
 
-void printTime()
+void printTime(uint8_t changed)
+// Only update the fields that have changed since the last read
 {
-  lcd.setCursor(0,0);
-  lcd.print(dow2String(myRTC.dow));
-  lcd.print(myRTC.yyyy);
-  lcd.print("-");
-  p2dig(myRTC.mm);
-  lcd.print("-");
-  p2dig(myRTC.dd);
+  if (changed & DS1307_FLD_DOW)
+  {
+    lcd.setCursor(0,0);
+    lcd.print(dow2String(myRTC.dow));
+  }
+  if (changed & DS1307_FLD_YEAR)
+  {
+    lcd.setCursor(4,0);
+    lcd.print(myRTC.yyyy);
+    lcd.print("-");
+  }
+  if (changed & DS1307_FLD_MON)
+  {
+    lcd.setCursor(9,0);
+    p2dig(myRTC.mm);
+    lcd.print("-");
+  }
+  if (changed & DS1307_FLD_DATE)
+  {
+    lcd.setCursor(12,0);
+    p2dig(myRTC.dd);
+  }
 
-  lcd.setCursor(0,1);
-  p2dig(myRTC.h);
-  lcd.print(":");
-  p2dig(myRTC.m);
-  lcd.print(":");
-  p2dig(myRTC.s);
-  if (myRTC.status(DS1307_12H) == DS1307_ON)
-    lcd.print(myRTC.pm ? " pm" : " am");
+  if (changed & DS1307_FLD_HOUR)
+  {
+    lcd.setCursor(0,1);
+    p2dig(myRTC.h);
+    lcd.print(":");
+  }
+  if (changed & DS1307_FLD_MIN)
+  {
+    lcd.setCursor(3,1);
+    p2dig(myRTC.m);
+    lcd.print(":");
+  }
+  if (changed & DS1307_FLD_SEC)
+  {
+    lcd.setCursor(6,1);
+    p2dig(myRTC.s);
+  }
+  if (changed & (DS1307_FLD_HOUR | DS1307_FLD_PM))
+  {
+    lcd.setCursor(8,1);
+    if (myRTC.status(DS1307_12H) == DS1307_ON)
+      lcd.print(myRTC.pm ? " pm" : " am");
+    else
+      lcd.print("   ");
+  }
 }
 
 void loop()
 {
-  myRTC.readTime();
-  printTime(); 
+  static bool first = true;
+  uint8_t changed = myRTC.readTime();
+
+  // the first time round draw everything
+  if (first)
+  {
+    changed = 0xff;
+    first = false;
+  }
+
+  if (changed != 0)
+    printTime(changed);
   delay(100);
 }
-
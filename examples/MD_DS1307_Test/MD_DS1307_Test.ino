@@ -8,16 +8,14 @@
 #define PRINTS(s) Serial.print(F(s));
 #define PRINT(s, v) { Serial.print(F(s)); Serial.print(v); }
 
-#ifdef ARDUINO_ARCH_SAMD
 MD_DS1307 myRTC;  ///< Locally created instance of the RTC class
-#else
-#define myRTC RTC ///< Library created instance of the RTC class
-#endif
 
 void setup()
 {
   Serial.begin(57600);
   PRINTS("[MD_DDS1307_Test]");
+
+  PRINT("\nRTC begin:\t", myRTC.begin());
   
   usage();
 }
@@ -160,15 +158,13 @@ void showStatus()
 
 void printTime()
 {
-  PRINT("", myRTC.yyyy);
-  PRINT("-", p2dig(myRTC.mm, DEC));
-  PRINT("-", p2dig(myRTC.dd, DEC));
-  PRINT(" ", p2dig(myRTC.h, DEC));
-  PRINT(":", p2dig(myRTC.m, DEC));
-  PRINT(":", p2dig(myRTC.s, DEC));
+  char buf[DS1307_FMT_LEN + 8];
+
   if (myRTC.status(DS1307_12H) == DS1307_ON)
-    PRINT(" ", myRTC.pm ? "pm" : "am");
-  PRINT(" ", dow2String(myRTC.dow));
+    myRTC.format(buf, sizeof(buf), F("%Y-%m-%d %I:%M:%S %p %a"));
+  else
+    myRTC.format(buf, sizeof(buf), F("%Y-%m-%d %H:%M:%S %a"));
+  Serial.print(buf);
 }
 
 void showTime()
@@ -182,22 +178,22 @@ void showRAM()
 {
   #define  MAX_READ_BUF  (DS1307_RAM_MAX / 8)  // do 8 lines
  
-  uint8_t  buf[MAX_READ_BUF];
+  uint8_t  buf[DS1307_RAM_MAX];
+
+  myRTC.dumpRAM(buf);   // read it all in one go
 
   for (int i=0; i<DS1307_RAM_MAX; i+=MAX_READ_BUF)
   {
-    myRTC.readRAM(i, buf, MAX_READ_BUF);
-    
     PRINT("\n", p2dig(i, HEX));
     PRINTS(":");
     for (int j = 0; j < MAX_READ_BUF; j++)
-      PRINT(" ", p2dig(buf[j], HEX));
+      PRINT(" ", p2dig(buf[i+j], HEX));
     PRINTS("  ");
     for (int j=0; j<MAX_READ_BUF; j++)
     {
-      if (isalnum(buf[j]) || ispunct(buf[j]))
+      if (isalnum(buf[i+j]) || ispunct(buf[i+j]))
       {
-        PRINT(" ", (char)buf[j]);
+        PRINT(" ", (char)buf[i+j]);
       }
       else
         PRINTS(" .");
@@ -242,6 +238,7 @@ void writeTime()
   myRTC.dd = i2dig(DEC);
   
   myRTC.h = i2dig(DEC);
+  myRTC.pm = (myRTC.h >= 12);   // the hour is entered as 24 hour time
   myRTC.m = i2dig(DEC);
   myRTC.s = i2dig(DEC);
   
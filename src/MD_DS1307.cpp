@@ -9,324 +9,516 @@
   version 2.1 of the License, or (at your option) any later version.
  */
 #include "MD_DS1307.h"
-#include <Wire.h>
-
-#ifndef ARDUINO_ARCH_SAMD
-class MD_DS1307 RTC;  // one instance created when library is included
-#endif
-
-// Useful definitions
-#define	DS1307_ID	0x68  // I2C/TWI device address, coded into the device
-
-#define RAM_BASE_READ   0 // smallest read address
-#define RAM_BASE_WRITE  8 // smallest write address
-
-// Addresses for the parts of the date/time in RAM
-#define ADDR_SEC  ((uint8_t)0x0)
-#define ADDR_MIN  ((uint8_t)0x1)
-#define ADDR_HR   ((uint8_t)0x2)
-#define ADDR_DAY  ((uint8_t)0x3)
-#define ADDR_DATE ((uint8_t)0x4)
-#define ADDR_MON  ((uint8_t)0x5)
-#define ADDR_YR   ((uint8_t)0x6)
-
-// Address for the special control bytes
-#define ADDR_CTL_CH   ((uint8_t)0x0)
-#define ADDR_CTL_12H  ((uint8_t)0x2)
-#define ADDR_CTL_OUT  ((uint8_t)0x7)
-#define ADDR_CTL_SQWE ((uint8_t)0x7)
-#define ADDR_CTL_RS   ((uint8_t)0x7)
-
-// Bit masks for the control/testable bits
-#define CTL_CH    ((uint8_t)0x80)
-#define CTL_12H   ((uint8_t)0x40)
-#define CTL_PM    ((uint8_t)0x20)
-#define CTL_OUT   ((uint8_t)0x80)
-#define CTL_SQWE  ((uint8_t)0x10)
-#define CTL_RS    ((uint8_t)0x03)
-
-// Define a global buffer we can use in these functions
-#define MAX_BUF   8     // time message is the biggest message we need to handle (7 bytes)
-uint8_t	bufRTC[MAX_BUF];
-
-// BCD to binary number packing/unpacking functions
-/*  // Second time Definitions
-static uint8_t BCD2bin(uint8_t v) { return v - 6 * (v >> 4); }
-static uint8_t bin2BCD (uint8_t v) { return v + 6 * (v / 10); }
-*/
-
-// Interface functions for the RTC device
-uint8_t MD_DS1307::readDevice(uint8_t addr, uint8_t* buf, uint8_t len)
+
+// Register map constants, for any odr-use
+constexpr uint8_t MD_DS1307Base::DS1307_ID;
+constexpr uint8_t MD_DS1307Base::RAM_BASE_READ;
+constexpr uint8_t MD_DS1307Base::RAM_BASE_WRITE;
+constexpr uint8_t MD_DS1307Base::ADDR_SEC;
+constexpr uint8_t MD_DS1307Base::ADDR_MIN;
+constexpr uint8_t MD_DS1307Base::ADDR_HR;
+constexpr uint8_t MD_DS1307Base::ADDR_DAY;
+constexpr uint8_t MD_DS1307Base::ADDR_DATE;
+constexpr uint8_t MD_DS1307Base::ADDR_MON;
+constexpr uint8_t MD_DS1307Base::ADDR_YR;
+constexpr uint8_t MD_DS1307Base::ADDR_CTL_CH;
+constexpr uint8_t MD_DS1307Base::ADDR_CTL_12H;
+constexpr uint8_t MD_DS1307Base::ADDR_CTL_OUT;
+constexpr uint8_t MD_DS1307Base::ADDR_CTL_SQWE;
+constexpr uint8_t MD_DS1307Base::ADDR_CTL_RS;
+constexpr uint8_t MD_DS1307Base::CTL_CH;
+constexpr uint8_t MD_DS1307Base::CTL_12H;
+constexpr uint8_t MD_DS1307Base::CTL_PM;
+constexpr uint8_t MD_DS1307Base::CTL_OUT;
+constexpr uint8_t MD_DS1307Base::CTL_SQWE;
+constexpr uint8_t MD_DS1307Base::CTL_RS;
+
+// 12 hour register values (12H, PM and BCD hour) indexed by the 24 hour time
+static const uint8_t hour12[24] PROGMEM =
 {
-  Wire.beginTransmission(DS1307_ID);
-  Wire.write(addr);       // set register address                  
-  if (Wire.endTransmission() != 0)
-    return(0);
+  0x52, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x50, 0x51,
+  0x72, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x70, 0x71
+};
 
-  Wire.requestFrom(DS1307_ID, (int)len);
-  // while (!Wire.available()) ;  // wait
-  for (uint8_t i=0; i<len; i++) // Read x data from given address upwards...
-  {
-    buf[i] = Wire.read();       // ... and store it in the buffer
-  }
+// Bus independent time functions, shared by all bus types
+MD_DS1307Base::MD_DS1307Base(void)
+{
+  yyyy = mm = dd = 0;
+  h = m = s = 0;
+  dow = 0;
+  pm = 0;
+  _mode12 = false;
+}
 
-  return(len);
+void MD_DS1307Base::unpackTime(const uint8_t *buf)
+// Unpack the time registers in buf into the object variables
+{
+  uint8_t hr = buf[ADDR_HR];
+
+  s = BCD2bin(buf[ADDR_SEC] & ~CTL_CH);  // mask off the 'CH' bit
+  m = BCD2bin(buf[ADDR_MIN]);
+  _mode12 = (hr & CTL_12H);
+  h = BCD2bin(hr & (_mode12 ? 0x1f : 0x3f));
+  pm = ((hr >> 1) & hr & CTL_PM) != 0;   // PM only counts with the 12H bit (next bit up) set
+  dow = BCD2bin(buf[ADDR_DAY]);
+  dd = BCD2bin(buf[ADDR_DATE]);
+  mm = BCD2bin(buf[ADDR_MON]);
+  yyyy = BCD2bin(buf[ADDR_YR]) + 2000;
 }
 
-uint8_t MD_DS1307::writeDevice(uint8_t addr, uint8_t* buf, uint8_t len)
+bool MD_DS1307Base::frameValid(const uint8_t *buf)
+// Check that the time registers in buf hold BCD values in range for 
+// each field, and a date that exists
 {
-  Wire.beginTransmission(DS1307_ID);
-  Wire.write(addr);             // set register address                  
-  for (uint8_t i=0; i<len; i++) // Send x data from given address upwards...
+  static const uint8_t lo[7] PROGMEM = { 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x00 };
+  static const uint8_t hi[7] PROGMEM = { 0x59, 0x59, 0x23, 0x07, 0x31, 0x12, 0x99 };
+  uint8_t hr = buf[ADDR_HR];
+
+  for (uint8_t i = 0; i < 7; i++)
   {
-    Wire.write(buf[i]);         // ... and send it from buffer
+    uint8_t v = buf[i];
+
+    if (i == ADDR_SEC) v &= ~CTL_CH;
+    else if (i == ADDR_HR) v = (hr & CTL_12H) ? hr & 0x1f : hr;
+
+    if ((v & 0xf) > 9 || v < pgm_read_byte(&lo[i]) || v > pgm_read_byte(&hi[i]))
+      return(false);
   }
-  Wire.endTransmission();
 
-  return(len);
+  if ((hr & CTL_12H) && ((hr & 0x1f) < 0x01 || (hr & 0x1f) > 0x12))
+    return(false);
+
+  return(BCD2bin(buf[ADDR_DATE]) <= daysInMonth(BCD2bin(buf[ADDR_YR]) + 2000, BCD2bin(buf[ADDR_MON])));
 }
 
-void MD_DS1307::init()
+uint8_t MD_DS1307Base::daysInMonth(uint16_t yyyy, uint8_t mm)
+// Return the number of days in the month, allowing for leap years
 {
-  yyyy = mm = dd = 0;
-  h = m = s = 0;
-  dow = 0;
+  static const uint8_t dim[] PROGMEM = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+  if (mm == 2 && (yyyy % 4 == 0) && ((yyyy % 100 != 0) || (yyyy % 400 == 0)))
+    return(29);
+
+  return(pgm_read_byte(&dim[mm - 1]));
 }
 
-// Class functions
-MD_DS1307::MD_DS1307()
+void MD_DS1307Base::advance(uint32_t secs, bool mode12)
+// Move the time in the object variables forward by secs seconds
 {
-  init();
-  Wire.begin();
+  uint8_t hr = h;
+  uint32_t days;
+
+  if (mode12)   // work in 24 hour time
+    hr = (h % 12) + (pm ? 12 : 0);
+
+  // seconds since midnight, split into whole days and time of day
+  secs += s + (60UL * (m + (60UL * hr)));
+  days = secs / 86400UL;
+  secs %= 86400UL;
+
+  hr = secs / 3600;
+  secs %= 3600;
+  m = secs / 60;
+  s = secs % 60;
+
+  if (mode12)
+  {
+    pm = (hr >= 12);
+    h = hr % 12;
+    if (h == 0) h = 12;
+  }
+  else
+    h = hr;
+
+  if (days == 0)
+    return;
+
+  if (dow >= 1 && dow <= 7)
+    dow = ((dow - 1 + days) % 7) + 1;
+
+  // move the date on, a whole month at a time where possible
+  while (days != 0)
+  {
+    uint8_t dim = daysInMonth(yyyy, mm);
+
+    if (dd + days <= dim)
+    {
+      dd += days;
+      break;
+    }
+
+    days -= dim - dd + 1;
+    dd = 1;
+    if (++mm > 12)
+    {
+      mm = 1;
+      yyyy++;
+    }
+  }
+}
+
+void MD_DS1307Base::packTime(uint8_t *buf, bool mode12)
+// Pack the object variables into the time registers in buf. 
+// In 12 hour mode hours above 12 are taken as 24 hour time, otherwise pm applies.
+{
+  _mode12 = mode12;
+  buf[ADDR_SEC] = bin2BCD(s);
+  buf[ADDR_MIN] = bin2BCD(m);
+  if (mode12)     // 12 hour clock, look up the register from the 24 hour time
+  {
+    uint8_t hr = h;
+
+    if (hr == 12 && !pm)
+      hr = 0;
+    else if (hr < 12 && pm)
+      hr += 12;
+    buf[ADDR_HR] = pgm_read_byte(&hour12[hr]);
+  }
+  else
+    buf[ADDR_HR] = bin2BCD(h);
+
+  buf[ADDR_DAY] = bin2BCD(dow);
+  buf[ADDR_DATE] = bin2BCD(dd);
+  buf[ADDR_MON] = bin2BCD(mm);
+  buf[ADDR_YR] = bin2BCD(yyyy - 2000);
 }
 
-#ifdef ESP8266
-MD_DS1307::MD_DS1307(int sda, int scl)
+bool MD_DS1307Base::fieldRange(uint8_t fields, uint8_t &lo, uint8_t &hi)
+// Work out the register range covering the DS1307_FLD_* fields.
+// Return false if no fields are selected.
 {
-  init();
-  Wire.begin(sda, scl);
+  if (fields & DS1307_FLD_PM)   // pm lives in the hours register
+    fields |= DS1307_FLD_HOUR;
+  fields &= DS1307_FLD_ALL;
+  if (fields == 0)
+    return(false);
+
+  for (lo = ADDR_SEC; !(fields & (1 << lo)); lo++) ;
+  for (hi = ADDR_YR; !(fields & (1 << hi)); hi--) ;
+
+  return(true);
 }
-#endif
- 
-void MD_DS1307::readTime(void)
-// Read the current time from the RTC and unpack it into the object variables
+
+uint8_t MD_DS1307Base::convertHour(uint8_t v, bool to12)
+// Convert the hours register value v between 12 and 24 hour time. 
+// The 12H bit itself is left for the caller to set.
 {
-  readDevice(RAM_BASE_READ, bufRTC, 7);   // get the data
+  uint8_t hour;
 
-  // unpack it
-  s = BCD2bin(bufRTC[ADDR_SEC] & ~CTL_CH);  // mask off the 'CH' bit
-  m = BCD2bin(bufRTC[ADDR_MIN]);
-  if (bufRTC[ADDR_HR] & CTL_12H)      // 12 hour clock
+  if (to12)
   {
-    h = BCD2bin(bufRTC[ADDR_HR] & 0x1f);
-    pm = (bufRTC[ADDR_HR] & CTL_PM);
+    if (!(v & CTL_12H))    // not already 12H mode
+    {
+      hour = BCD2bin(v & 0x3f);
+      v = pgm_read_byte(&hour12[hour]) & ~CTL_12H;
+    }
   }
   else
   {
-    h = BCD2bin(bufRTC[ADDR_HR] & 0x3f);
-    pm = 0;
+    if (v & CTL_12H)      // not already 24H mode
+    {
+      hour = BCD2bin(v & 0x1f);
+      if (hour == 12) hour = 0;
+      if (v & CTL_PM) hour += 12;
+      v = bin2BCD(hour);
+    }
   }
-  dow = BCD2bin(bufRTC[ADDR_DAY]);
-  dd = BCD2bin(bufRTC[ADDR_DATE]);
-  mm = BCD2bin(bufRTC[ADDR_MON]);
-  yyyy = BCD2bin(bufRTC[ADDR_YR]) + 2000;
+
+  return(v);
 }
 
-void MD_DS1307::writeTime(void)
-// Pack up and write the time stored in the object variables to the RTC
-// Note: Setting the time will also start the clock of it is halted
+void MD_DS1307Base::civilFromDays(uint16_t days, uint16_t &yyyy, uint8_t &mm, uint8_t &dd)
+// Inverse of daysFromCivil(). Count from 1 Mar 1996 so that the leap day is 
+// the last day of each 1461 day block. All the arithmetic fits in 16 bits.
 {
-  uint8_t	mode12;
-
-  // check what time mode is current
-  readDevice(ADDR_HR, &mode12, 1);
-  mode12 &= CTL_12H;
+  uint16_t n = days + 1401;
+  uint16_t r = n % 1461;                // day in the 4 year block
+  uint8_t  y = (r - r / 1460) / 365;    // year in the block, with the leap day in year 3
+  uint16_t doy = r - (365U * y);        // day in the March based year
+  uint8_t  mp = (5 * doy + 2) / 153;    // month in the March based year, 0 = March
+
+  dd = doy - ((153U * mp + 2) / 5) + 1;
+  mm = mp < 10 ? mp + 3 : mp - 9;
+  yyyy = 1996 + (4 * (n / 1461)) + y + (mm <= 2);
+}
 
-  // pack it up in the current space
-  bufRTC[ADDR_SEC] = bin2BCD(s);
-  bufRTC[ADDR_MIN] = bin2BCD(m);
-  if (mode12)     // 12 hour clock
+static void civilKernel(const ds1307Time_t * __restrict__ t, size_t n, uint16_t * __restrict__ yyyy, 
+  uint8_t * __restrict__ mm, uint8_t * __restrict__ dd, uint8_t * __restrict__ h,
+  uint8_t * __restrict__ m, uint8_t * __restrict__ s, uint8_t * __restrict__ dow)
+// The calculation of civilFromDays() and the time of day, in 32 bit 
+// arithmetic throughout and with the month adjustments done without 
+// branches, so that the loop can be vectorised. The arrays are declared 
+// as not overlapping, to save the compiler checking for it.
+{
+  for (size_t i = 0; i < n; i++)
   {
-    pm = (h > 12);
-    if (pm) h -= 12;
-    bufRTC[ADDR_HR] = bin2BCD(h);
-    if (pm) bufRTC[ADDR_HR] |= CTL_PM;
-    bufRTC[ADDR_HR] |= CTL_12H;
+    uint32_t days = t[i] / 86400UL;
+    uint32_t secs = t[i] - (days * 86400UL);
+    uint32_t d = days + 1401;             // days from 1 Mar 1996
+    uint32_t r = d % 1461;                // day in the 4 year block
+    uint32_t y = (r - r / 1460) / 365;    // year in the block
+    uint32_t doy = r - (365 * y);         // day in the March based year
+    uint32_t mp = (5 * doy + 2) / 153;    // month in the March based year, 0 = March
+    uint32_t jf = (mp >= 10);             // January or February
+
+    yyyy[i] = 1996 + (4 * (d / 1461)) + y + jf;
+    mm[i] = mp + 3 - (12 * jf);
+    dd[i] = doy - ((153 * mp + 2) / 5) + 1;
+    h[i] = secs / 3600;
+    m[i] = (secs / 60) % 60;
+    s[i] = secs % 60;
+    dow[i] = ((days + 6) % 7) + 1;        // 1 Jan 2000 was a Saturday
   }
-  else
-    bufRTC[ADDR_HR] = bin2BCD(h);
+}
+
+void MD_DS1307Base::civilFromTimes(const ds1307Time_t *t, size_t n, const timeArray_t &f)
+{
+  civilKernel(t, n, f.yyyy, f.mm, f.dd, f.h, f.m, f.s, f.dow);
+}
 
-  bufRTC[ADDR_DAY] = bin2BCD(dow);
-  bufRTC[ADDR_DATE] = bin2BCD(dd);
-  bufRTC[ADDR_MON] = bin2BCD(mm);
-  bufRTC[ADDR_YR] = bin2BCD(yyyy - 2000);
+static void timesKernel(const uint16_t * __restrict__ yyyy, const uint8_t * __restrict__ mm, 
+  const uint8_t * __restrict__ dd, const uint8_t * __restrict__ h, const uint8_t * __restrict__ m,
+  const uint8_t * __restrict__ s, size_t n, ds1307Time_t * __restrict__ t)
+// The calculation of makeTime(), with the month adjustments done without 
+// branches, so that the loop can be vectorised. The arrays are declared 
+// as not overlapping, as for civilKernel().
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    uint32_t jf = (mm[i] <= 2);                 // January or February
+    uint32_t yy = yyyy[i] - jf - 1996;          // years from 1 Mar 1996
+    uint32_t mp = mm[i] + 9 - (12 * (1 - jf));  // month in the March based year, 0 = March
+    uint32_t days = (365 * yy) + (yy / 4) + ((153 * mp + 2) / 5) + dd[i] - 1 - 1401;
 
-  writeDevice(RAM_BASE_READ, bufRTC, 7);
+    t[i] = (days * 86400UL) + (h[i] * 3600UL) + (m[i] * 60UL) + s[i];
+  }
 }
 
-uint8_t MD_DS1307::readRAM(uint8_t addr, uint8_t* buf, uint8_t len)
-// Read len bytes from the RTC, starting at address addr, and put them in buf
-// Reading includes all bytes at addresses RAM_BASE_READ to DS1307_RAM_MAX
+void MD_DS1307Base::timesFromCivil(const timeArray_t &f, size_t n, ds1307Time_t *t)
 {
-  if ((NULL == buf) || (addr < RAM_BASE_READ) ||
-      (len == 0) ||(addr + len - 1 > DS1307_RAM_MAX))
-    return(0);
+  timesKernel(f.yyyy, f.mm, f.dd, f.h, f.m, f.s, n, t);
+}
+
+uint8_t MD_DS1307Base::hour24(void)
+// Return the hour in the object variables as 24 hour time
+{
+  uint8_t hr = h;
 
-  return(readDevice(addr, buf, len));   // read all the data once
+  if (pm)
+    hr = (hr % 12) + 12;
+  else if (_mode12 && hr == 12)   // midnight
+    hr = 0;
+
+  return(hr);
 }
 
-uint8_t MD_DS1307::writeRAM(uint8_t addr, uint8_t* buf, uint8_t len)
-// Write len bytes from buffer buf to the RTC, starting at address addr
-// Writing addresses excludes the RTC registers, so valid addresses are 
-// RAM_BASE_WRITE to DS1307_RAM_MAX
+ds1307Time_t MD_DS1307Base::getTime(void)
+// Pack the object variables into seconds since 1 Jan 2000
 {
-  if ((NULL == buf) || (addr < RAM_BASE_WRITE) || 
-      (len == 0) || (addr + len - 1 >= DS1307_RAM_MAX))
-    return(0);
+  return(makeTime(yyyy, mm, dd, hour24(), m, s));
+}
+
+// Day and month names for formatting and parsing, 3 characters each
+static const char dowName[] PROGMEM = "---SunMonTueWedThuFriSat";
+static const char monName[] PROGMEM = "JanFebMarAprMayJunJulAugSepOctNovDec";
 
-  return(writeDevice(addr, buf, len));  // write all the data at once
+static uint8_t put2dig(char *buf, uint8_t n, uint8_t len, uint8_t v)
+// Append v as 2 decimal digits, as far as there is room
+{
+  v = MD_DS1307Base::bin2BCD(v);
+  if (n < len) buf[n++] = '0' + (v >> 4);
+  if (n < len) buf[n++] = '0' + (v & 0xf);
+  return(n);
 }
 
-uint8_t MD_DS1307::calcDoW(uint16_t yyyy, uint8_t mm, uint8_t dd) 
-// https://en.wikipedia.org/wiki/Determination_of_the_day_of_the_week
-// This algorithm good for dates  yyyy > 1752 and  1 <= mm <= 12
-// Returns dow  01 - 07, 01 = Sunday
+static uint8_t putName(char *buf, uint8_t n, uint8_t len, const char *name)
+// Append a 3 character name from program memory, as far as there is room
 {
-  static int t[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
-    
-  yyyy -= mm < 3;
-  return ((yyyy + yyyy/4 - yyyy/100 + yyyy/400 + t[mm-1] + dd) % 7) + 1;
+  for (uint8_t i = 0; i < 3 && n < len; i++)
+    buf[n++] = pgm_read_byte(name + i);
+  return(n);
 }
 
-void MD_DS1307::control(uint8_t item, uint8_t value)
-// Perform a control action on item, using the value
+uint8_t MD_DS1307Base::formatText(char *buf, uint8_t len, const char *fmt, bool progmem)
+// Write the object variables into buf as specified by the pattern fmt
 {
-  uint8_t mask;   // mask used to clear the bits being set (ANDed)
-  uint8_t cmd;    // value used to set new nit value (ORed)
-  uint8_t addr;   // address of the byte to change
+  uint8_t n = 0;
+  uint8_t hr = hour24();
+  char c;
 
-  switch (item)
+  if (buf == NULL || len == 0)
+    return(0);
+
+  len--;    // leave room for the nul
+  while (fmt != NULL && n < len)
   {
-    case DS1307_CLOCK_HALT:
-      addr = ADDR_CTL_CH;
-      mask = (uint8_t)~CTL_CH;
-      switch (value)
-      {
-        case DS1307_ON:  cmd = CTL_CH;  break;
-        case DS1307_OFF: cmd = 0;       break;
-        default: return; // wrong - just go back
-      }
-    break;
-
-    case DS1307_SQW_RUN:
-      addr = ADDR_CTL_SQWE;
-      mask = (uint8_t)~CTL_SQWE;
-      switch (value)
-      {
-        case DS1307_ON:  cmd = CTL_SQWE;  break;
-        case DS1307_OFF: cmd = 0;         break;
-        default: return; // wrong - just go back
-      }
-    break;
-
-    case DS1307_SQW_TYPE_ON:
-      addr = ADDR_CTL_RS;
-      mask = (uint8_t)~CTL_RS;
-      switch (value)
-      {
-        case DS1307_SQW_1HZ:  cmd = 0x00; break;
-        case DS1307_SQW_4KHZ: cmd = 0x01; break;
-        case DS1307_SQW_8KHZ: cmd = 0x02; break;
-        case DS1307_SQW_32KHZ:cmd = 0x03; break;
-        default: return; // wrong - just go back
-      }
-    break;
-
-    case DS1307_SQW_TYPE_OFF:
-      addr = ADDR_CTL_OUT;
-      mask = (uint8_t)~CTL_OUT;
-      switch (value)
-      {
-        case DS1307_SQW_LOW:  cmd = 0;        break;
-        case DS1307_SQW_HIGH: cmd = CTL_OUT;  break;
-        default: return; // wrong - just go back
-      }
-    break;
-
-    case DS1307_12H:
-      addr = ADDR_CTL_12H;
-      mask = (uint8_t)~CTL_12H;
-      switch (value)
-      {
-        case DS1307_ON:  cmd = CTL_12H; break;
-        case DS1307_OFF: cmd = 0;       break;
-        default: return; // wrong - just go back
-      }
-    break;
-
-    default:
-      return;	// parameters were wrong - make no fuss and just go back
+    c = progmem ? pgm_read_byte(fmt++) : *fmt++;
+    if (c == '\0')
+      break;
+    if (c != '%')
+    {
+      buf[n++] = c;
+      continue;
+    }
+
+    c = progmem ? pgm_read_byte(fmt++) : *fmt++;
+    switch (c)
+    {
+      case 'Y': n = put2dig(buf, n, len, 20); n = put2dig(buf, n, len, yyyy - 2000); break;
+      case 'y': n = put2dig(buf, n, len, yyyy - 2000); break;
+      case 'm': n = put2dig(buf, n, len, mm);         break;
+      case 'd': n = put2dig(buf, n, len, dd);         break;
+      case 'H': n = put2dig(buf, n, len, hr);         break;
+      case 'I': n = put2dig(buf, n, len, hr > 12 ? hr - 12 : (hr == 0 ? 12 : hr)); break;
+      case 'M': n = put2dig(buf, n, len, m);          break;
+      case 'S': n = put2dig(buf, n, len, s);          break;
+      case 'p': 
+        buf[n++] = (hr < 12 ? 'a' : 'p');
+        if (n < len) buf[n++] = 'm';
+        break;
+      case 'a': n = putName(buf, n, len, &dowName[(dow > 7 ? 0 : dow) * 3]); break;
+      case 'b': n = putName(buf, n, len, (mm < 1 || mm > 12) ? dowName : &monName[(mm - 1) * 3]); break;
+      case '\0': fmt--; break;   // pattern ends with %
+      default:  buf[n++] = c;    break;   // includes %%
+    }
   }
+  buf[n] = '\0';
 
-  // now read the address from the RTC
-  readDevice(addr, bufRTC, 1);
+  return(n);
+}
 
-  // do any special processing here
-  if (item == DS1307_12H)   // changing 12/24H clock - special handling of hours conversion
-    switch(value)
-    {
-      case DS1307_ON:               // change to 12H ...
-        if (!(bufRTC[0] & CTL_12H)) // ... and not in 12H mode
-        {
-          uint8_t	hour = BCD2bin(bufRTC[0] & 0x3f);
-
-          if (hour > 12)      // adjust the time, otherwise it looks the same as it does
-          {
-            bufRTC[0] = bin2BCD(hour - 12);
-            bufRTC[0] |= CTL_PM;
-          }
-        }
-      break;
+static bool getNum(const char *&p, uint8_t digits, uint16_t &v)
+// Read a number of exactly digits characters at p. A leading space is
+// taken as a zero, for the __DATE__ day.
+{
+  v = 0;
+  for (uint8_t i = 0; i < digits; i++, p++)
+  {
+    if (*p >= '0' && *p <= '9')
+      v = (v * 10) + (*p - '0');
+    else if (!(i == 0 && *p == ' '))
+      return(false);
+  }
+  return(true);
+}
 
-      case DS1307_OFF:  // change to 24H ...
-        if ((bufRTC[0] & CTL_12H) && (bufRTC[0] & CTL_PM))  // ... not in 24H mode and it is PM
-        {
-          uint8_t	hour = BCD2bin(bufRTC[0] & 0x1f);
-          bufRTC[0] = bin2BCD(hour + 12);
-        }
-      break;
-    }
+static bool getChar(const char *&p, char c)
+// Skip the character c at p
+{
+  if (*p != c)
+    return(false);
+  p++;
+  return(true);
+}
+
+bool MD_DS1307Base::setCivil(uint16_t y, uint16_t mo, uint16_t d, uint16_t hr, uint16_t mi, uint16_t se)
+// Check the date and time and set the object variables from them
+{
+  if (y < 2000 || y > 2099 || mo < 1 || mo > 12 || d < 1 || 
+      d > daysInMonth(y, mo) || hr > 23 || mi > 59 || se > 59)
+    return(false);
+
+  yyyy = y;
+  mm = mo;
+  dd = d;
+  h = hr;
+  m = mi;
+  s = se;
+  pm = (hr >= 12);
+  dow = calcDoW(y, mo, d);
+
+  return(true);
+}
+
+bool MD_DS1307Base::parseISO(const char *str)
+// Parse yyyy-mm-ddThh:mm:ss into the object variables
+{
+  uint16_t y, mo, d, hr, mi, se;
 
-  // Mask off the new status, set the value and then write it back
-  bufRTC[0] &= mask;
-  bufRTC[0] |= cmd;
-  writeDevice(addr, bufRTC, 1);
+  if (str == NULL ||
+      !getNum(str, 4, y) || !getChar(str, '-') || !getNum(str, 2, mo) || !getChar(str, '-') || !getNum(str, 2, d) ||
+      !(getChar(str, 'T') || getChar(str, ' ')) ||
+      !getNum(str, 2, hr) || !getChar(str, ':') || !getNum(str, 2, mi) || !getChar(str, ':') || !getNum(str, 2, se))
+    return(false);
 
-  return;
+  return(setCivil(y, mo, d, hr, mi, se));
 }
 
-uint8_t MD_DS1307::status(uint8_t item)
-// Obtain the status of the controllable item and return it.
-// Return DS1307_ERROR otherwise.
+bool MD_DS1307Base::parseBuild(const char *date, const char *time)
+// Parse the compiler __DATE__ ("Mmm dd yyyy") and __TIME__ ("hh:mm:ss") strings
 {
-  readDevice(RAM_BASE_READ, bufRTC, 8);   // read all the data once
+  uint16_t y, mo, d, hr, mi, se;
 
-  switch (item)
+  if (date == NULL || time == NULL)
+    return(false);
+
+  for (mo = 0; mo < 12; mo++)
+    if (strncmp_P(date, &monName[mo * 3], 3) == 0)
+      break;
+
+  date += 3;
+  if (mo == 12 || !getChar(date, ' ') || !getNum(date, 2, d) || !getChar(date, ' ') || !getNum(date, 4, y) ||
+      !getNum(time, 2, hr) || !getChar(time, ':') || !getNum(time, 2, mi) || !getChar(time, ':') || !getNum(time, 2, se))
+    return(false);
+
+  return(setCivil(y, mo + 1, d, hr, mi, se));
+}
+
+void MD_DS1307Base::unpackSeconds(ds1307Time_t t, bool mode12)
+// Unpack seconds since 1 Jan 2000 into the object variables
+{
+  uint16_t days = t / 86400UL;
+  uint32_t secs = t % 86400UL;
+
+  civilFromDays(days, yyyy, mm, dd);
+  dow = ((days + 6) % 7) + 1;   // 1 Jan 2000 was a Saturday
+  s = secs % 60;
+  secs /= 60;
+  m = secs % 60;
+  h = secs / 60;
+  pm = 0;
+  _mode12 = mode12;
+  if (mode12)
   {
-    case DS1307_CLOCK_HALT: return(bufRTC[ADDR_CTL_CH] & CTL_CH ? DS1307_ON : DS1307_OFF);
-    case DS1307_SQW_RUN:    return(bufRTC[ADDR_CTL_SQWE] & CTL_SQWE ? DS1307_ON : DS1307_OFF);
-    case DS1307_SQW_TYPE_ON:
-      switch (bufRTC[ADDR_CTL_RS] & CTL_RS)
-      {
-        case 0: return(DS1307_SQW_1HZ);
-        case 1: return(DS1307_SQW_4KHZ);
-        case 2: return(DS1307_SQW_8KHZ);
-        case 3: return(DS1307_SQW_32KHZ);
-      }
-      break;  // in case of error
-    case DS1307_SQW_TYPE_OFF: return(bufRTC[ADDR_CTL_OUT] & CTL_OUT ? DS1307_SQW_HIGH : DS1307_SQW_LOW);
-    case DS1307_12H:          return(bufRTC[ADDR_CTL_12H] & CTL_12H ? DS1307_ON : DS1307_OFF);
+    pm = (h >= 12);
+    h %= 12;
+    if (h == 0) h = 12;
   }
+}
 
-  return(DS1307_ERROR); // parameters were wrong - make no fuss and just go back
+void MD_DS1307Base::saveFields(uint8_t *prev)
+// Save the object variables in DS1307_FLD_* bit order
+{
+  prev[0] = s;
+  prev[1] = m;
+  prev[2] = h;
+  prev[3] = dow;
+  prev[4] = dd;
+  prev[5] = mm;
+  prev[6] = yyyy - 2000;
+  prev[7] = pm;
+}
+
+uint8_t MD_DS1307Base::changedFields(const uint8_t *prev)
+// Return the DS1307_FLD_* bits for object variables that differ from prev
+{
+  uint8_t cur[8];
+  uint8_t mask = 0;
+
+  saveFields(cur);
+  for (uint8_t i = 0; i < 8; i++)
+    if (cur[i] != prev[i]) mask |= (1 << i);
+
+  return(mask);
+}
+
+uint8_t MD_DS1307Base::calcDoW(uint16_t yyyy, uint8_t mm, uint8_t dd) 
+// https://en.wikipedia.org/wiki/Determination_of_the_day_of_the_week
+// This algorithm good for dates  yyyy > 1752 and  1 <= mm <= 12
+// Returns dow  01 - 07, 01 = Sunday
+{
+  static int t[] = {0, 3, 2, 5, 0, 3, 5, 1, 4, 6, 2, 4};
+    
+  yyyy -= mm < 3;
+  return ((yyyy + yyyy/4 - yyyy/100 + yyyy/400 + t[mm-1] + dd) % 7) + 1;
 }
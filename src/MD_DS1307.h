@@ -21,8 +21,9 @@ corrections for leap year.
 This library features access to all on-chip features
 - Read and write clock time registers
 - Access to the 64 byte battery backed up RAM
-- Read and write alarm registers and controls
-- Read/write clock and alarm registers as RAM
+- Software alarms (one-shot, interval, daily and weekly)
+- Time zone and daylight saving conversion from POSIX TZ rules
+- Read/write clock registers as RAM
 - Control of square wave generator (on/off & frequency)
 - Control of clock features (on/off, 12/24H, day of week)
 
@@ -35,6 +36,52 @@ ___
 
 Revision History 
 ----------------
+Oct 2026 version 1.4.0
+- Added optional I2C bus transaction accounting (DS1307_BUS_STATS).
+- The library RTC object is defined in its own file and the library is linked as 
+an archive, so the object only uses RAM in sketches that use it.
+- Added a host build in test/host, with Arduino and Wire stubs and a simulated 
+DS1307, to run the library tests without hardware.
+- Added optional shadow cache for the control register and status bits.
+- Added soft clock mode to extrapolate the time from millis() between RTC reads.
+- Added SQW 1Hz interrupt driven tick mode.
+- Added sub-second timestamps using the 4/8/32kHz SQW output as a timebase.
+- Added beginControl()/commitControl() to batch control() changes.
+- Fixed 12/24H conversion of 12 noon and midnight in control().
+- writeTime() can write only selected fields and no longer reads the hour mode 
+from the RTC or changes h and pm.
+- Added non-blocking asynchronous time and RAM operations run by poll().
+- Changed the class to a template MD_DS1307T on the I2C bus type, with MD_DS1307 
+as the type for the Wire library. Each object now has its own buffers.
+- RAM transfers are split to fit the I2C library buffer and return the true byte count.
+- Added dumpRAM() and restoreRAM() for the whole register file.
+- Added MD_DS1307NVRAM write-back cache for the battery backed RAM (MD_DS1307_NVRAM.h).
+- Added MD_DS1307Log ring buffer event log in the battery backed RAM (MD_DS1307_Log.h).
+- Added ds1307Time_t packed time (seconds since 2000) with constexpr makeTime() and 
+daysFromCivil(), civilFromDays(), getTime(), setTime(), readTime(ds1307Time_t&) 
+and timeAdd()/timeDiff()/timeCompare() helpers.
+- Time frame codec (packTime()/unpackTime()) made public, with division free 
+bin2BCD() and a program memory table for 12 hour register values.
+- Added control<item, value>() and status<item>() templates, resolved and checked 
+at compile time. status<item>() reads only the register holding the item.
+- readTime() returns a DS1307_FLD_* mask of the interface registers that changed. 
+The LCD example only redraws the changed fields.
+- Added format() to write the time as text from a pattern (ISO 8601 and others) 
+and parseISO()/parseBuild() to set the time from ISO 8601 or __DATE__/__TIME__ 
+text.
+- Added MD_DS1307Alarm software alarm scheduler (MD_DS1307_Alarm.h).
+- Added MD_DS1307Drift drift calibration saved in the battery backed RAM, corrected 
+with single seconds register writes (MD_DS1307_Drift.h).
+- The I2C bus is started by begin() instead of in the constructor. begin() also 
+checks the oscillator, time and an NVRAM header signature in one block read.
+- Bus statistics also count NACKs and short reads, and keep a histogram of the 
+measured call times for each operation.
+- Added MD_DS1307Snapshot for interrupt handlers to read a consistent copy of 
+the time (MD_DS1307_Snapshot.h).
+- Added MD_DS1307TZ time zone conversion from POSIX TZ rules, with the daylight 
+saving transitions cached for the year (MD_DS1307_TZ.h).
+- Added civilFromTimes() and timesFromCivil() to convert arrays of packed times.
+
 Dec 2018 version 1.3.5
 - Fixed RTC (re)declaration clash with SAMD architecture.
 
@@ -119,13 +166,31 @@ and time is then available in the interface registers.
 __Writing__ the current time is a sequence of writing to the interface registers followed by a call 
 to the writeTime() method.
 
+__Interrupt handlers__ should not read the interface registers, as readTime() changes them one 
+at a time. The MD_DS1307Snapshot object (MD_DS1307_Snapshot.h) holds a copy published by the 
+main loop after readTime(), which the interrupt handler reads consistently.
+
 The DS1307_LCD_Time example has examples of the different ways of interacting with the RTC.
+
+___
+
+Using Other I2C Buses
+---------------------
+The library class is the template MD_DS1307T, which takes the I2C bus class as its 
+parameter. MD_DS1307 is the type for the Arduino Wire library and the library RTC 
+object is of this type. To use another bus, such as a second hardware I2C port or a 
+software I2C library with the same methods as TwoWire, create an object for it:
+
+    MD_DS1307T<TwoWire> rtc2(Wire1);
+
+Each object is independent, so several RTCs can be used on separate buses.
 */
 
 #ifndef MD_DS1307_h
 #define MD_DS1307_h
 
 #include <Arduino.h>
+#include <Wire.h>
 /**
  * \file
  * \brief Main header file for the MD_DS1307 library
@@ -159,39 +224,643 @@ The DS1307_LCD_Time example has examples of the different ways of interacting wi
 #define DS1307_SQW_HIGH   7 ///< Represents a HIGH status to set or returned from a get
 #define DS1307_SQW_LOW    8 ///< Represents an LOW status to set or returned from a get
 
+/**
+ * Time field identifiers.
+ *
+ * These bit masks identify the time interface registers. They are combined 
+ * (ORed) to select the fields to be written by writeTime(). Each bit corresponds
+ * to the RTC register holding the field.
+ */
+#define DS1307_FLD_SEC    0x01  ///< Seconds (s)
+#define DS1307_FLD_MIN    0x02  ///< Minutes (m)
+#define DS1307_FLD_HOUR   0x04  ///< Hours (h)
+#define DS1307_FLD_DOW    0x08  ///< Day of week (dow)
+#define DS1307_FLD_DATE   0x10  ///< Date of the month (dd)
+#define DS1307_FLD_MON    0x20  ///< Month (mm)
+#define DS1307_FLD_YEAR   0x40  ///< Year (yyyy)
+#define DS1307_FLD_PM     0x80  ///< AM/PM indicator (pm), held in the same register as the hours
+#define DS1307_FLD_ALL    0x7f  ///< All the time registers
+
+/**
+ * Asynchronous transfer chunk size.
+ *
+ * The maximum number of RAM bytes transferred by each poll() step of an 
+ * asynchronous readRAM or writeRAM operation. Smaller values reduce the time 
+ * spent in each poll() at the cost of more I2C transactions. Only used when 
+ * DS1307_ASYNC is set to 1.
+ */
+#ifndef DS1307_ASYNC_CHUNK
+#define DS1307_ASYNC_CHUNK  8
+#endif
+
 // Device parameters
 #define DS1307_RAM_MAX  64  ///< Total number of RAM registers that can be read from the device
 
+/**
+ * Default battery backed RAM layout.
+ *
+ * The MD_DS1307Drift record is at the top of the RAM and the MD_DS1307Log 
+ * region fills the RAM below it, so both can be used with their default 
+ * addresses. Objects given other addresses must be kept apart by the 
+ * application. MD_DS1307NVRAM caches the whole RAM and can be used with either,
+ * as it only writes back the bytes changed through the cache.
+ */
+#define DS1307_DRIFT_SIZE 12  ///< Bytes of battery backed RAM used by the drift calibration record
+#define DS1307_DRIFT_ADDR (DS1307_RAM_MAX - DS1307_DRIFT_SIZE)  ///< Default RTC address of the drift calibration record
+#define DS1307_LOG_ADDR   8   ///< Default first RTC address of the event log region
+#define DS1307_LOG_SIZE   (DS1307_DRIFT_ADDR - DS1307_LOG_ADDR)   ///< Default size of the event log region
+
+static_assert(DS1307_LOG_ADDR >= 8 && DS1307_LOG_ADDR + DS1307_LOG_SIZE <= DS1307_DRIFT_ADDR && 
+              DS1307_DRIFT_ADDR + DS1307_DRIFT_SIZE <= DS1307_RAM_MAX, "DS1307 default RAM regions overlap");
+
+/**
+ * I2C library buffer size.
+ *
+ * The maximum number of bytes the I2C library can transfer in one transaction.
+ * Longer transfers are split into chunks of this size. This defaults to the 
+ * Wire library BUFFER_LENGTH where it is defined, otherwise 32 bytes.
+ */
+#ifndef DS1307_BUS_BUFFER
+#ifdef BUFFER_LENGTH
+#define DS1307_BUS_BUFFER BUFFER_LENGTH
+#else
+#define DS1307_BUS_BUFFER 32
+#endif
+#endif
+
+/**
+ * Bus statistics collection.
+ *
+ * Set this to 1 to count the I2C transactions, bytes, estimated bus time, 
+ * bus errors and measured call times for each public RTC operation. The 
+ * statistics are accessed with the getBusStats() and resetBusStats() methods. 
+ * When set to 0 the related code and data are not compiled into the library.
+ */
+#ifndef DS1307_BUS_STATS
+#define DS1307_BUS_STATS 0
+#endif
+
+/**
+ * Number of call time histogram buckets kept by the bus statistics.
+ *
+ * Bucket 0 counts calls taking less than DS1307_STATS_BUCKET_US microseconds 
+ * and each following bucket covers twice the time of the one before, with the 
+ * last bucket counting all the longer calls.
+ */
+#ifndef DS1307_STATS_BUCKETS
+#define DS1307_STATS_BUCKETS 6
+#endif
+
+/**
+ * Upper limit in microseconds of the first call time histogram bucket.
+ */
+#ifndef DS1307_STATS_BUCKET_US
+#define DS1307_STATS_BUCKET_US 128
+#endif
+
+/**
+ * Control register batching.
+ *
+ * Set this to 1 to compile in beginControl() and commitControl(). When set 
+ * to 0 the related code and data are not compiled into the library.
+ */
+#ifndef DS1307_CONTROL_BATCH
+#define DS1307_CONTROL_BATCH 0
+#endif
+
+/**
+ * Soft clock.
+ *
+ * Set this to 1 to compile in the soft clock, softClock() and resync(). When 
+ * set to 0 the related code and data are not compiled into the library.
+ */
+#ifndef DS1307_SOFT_CLOCK
+#define DS1307_SOFT_CLOCK 0
+#endif
+
+/**
+ * SQW interrupt tick and high resolution modes.
+ *
+ * Set this to 1 to compile in tickBegin(), fineBegin() and the related 
+ * methods. When set to 0 the related code and data are not compiled into 
+ * the library.
+ */
+#ifndef DS1307_SQW_TICK
+#define DS1307_SQW_TICK 0
+#endif
+
+/**
+ * Asynchronous operations.
+ *
+ * Set this to 1 to compile in the non-blocking methods run by poll(). When 
+ * set to 0 the related code and data are not compiled into the library.
+ */
+#ifndef DS1307_ASYNC
+#define DS1307_ASYNC 0
+#endif
+
+/**
+ * Configuration overrides.
+ *
+ * The options above only affect the MD_DS1307T template, which is compiled in
+ * the sketch, so a sketch can set them before including this header. The 
+ * library RTC object is compiled with the library defaults, so a sketch that 
+ * changes them should declare its own object and not use RTC.
+ */
+
+/**
+ * Bus statistics operation identifiers.
+ *
+ * These definitions are used with the getBusStats() method to identify the 
+ * public operation for which statistics are required.
+ */
+#define DS1307_OP_READ_TIME   0 ///< Statistics for readTime()
+#define DS1307_OP_WRITE_TIME  1 ///< Statistics for writeTime()
+#define DS1307_OP_STATUS      2 ///< Statistics for status()
+#define DS1307_OP_CONTROL     3 ///< Statistics for control()
+#define DS1307_OP_READ_RAM    4 ///< Statistics for readRAM()
+#define DS1307_OP_WRITE_RAM   5 ///< Statistics for writeRAM()
+#define DS1307_OP_BEGIN       6 ///< Statistics for begin()
+#define DS1307_OP_COUNT       7 ///< Number of operations for which statistics are kept
+
+/**
+ * Startup health check flags.
+ *
+ * These definitions are returned by the begin() method, ORed together. 
+ * DS1307_BOOT_OK means the RTC answered, is running and holds a valid time.
+ */
+#define DS1307_BOOT_OK        0x00  ///< No problems found
+#define DS1307_BOOT_NO_RTC    0x01  ///< The RTC did not answer; the other flags are not set
+#define DS1307_BOOT_HALTED    0x02  ///< The oscillator is halted, usually after power loss with no battery
+#define DS1307_BOOT_BAD_TIME  0x04  ///< The time registers do not hold a valid date and time
+#define DS1307_BOOT_BAD_SIG   0x08  ///< The NVRAM header does not start with the signature
+
+/**
+ * Time format patterns.
+ *
+ * These definitions are used with the format() method. The pattern codes are
+ * described with the format() method.
+ */
+#define DS1307_FMT_ISO    "%Y-%m-%dT%H:%M:%S" ///< ISO 8601 date and time, yyyy-mm-ddThh:mm:ss
+#define DS1307_FMT_DATE   "%Y-%m-%d"          ///< ISO 8601 date, yyyy-mm-dd
+#define DS1307_FMT_TIME   "%H:%M:%S"          ///< 24 hour time, hh:mm:ss
+#define DS1307_FMT_TIME12 "%I:%M:%S %p"       ///< 12 hour time, hh:mm:ss am/pm
+#define DS1307_FMT_LEN    20                  ///< Buffer size for DS1307_FMT_ISO, including the terminating nul
+
+/**
+ * Packed time type.
+ *
+ * Seconds since 00:00:00 on 1 Jan 2000, the start of the RTC calendar. The
+ * RTC range (2000 to 2099) fits in 32 bits, so a time can be stored in 4 bytes
+ * and compared or subtracted as a number.
+ */
+typedef uint32_t ds1307Time_t;
+
+/**
+ * Time data and calendar functions for the MD_DS1307 library
+ *
+ * Holds the time interface registers and the functions that do not need the 
+ * I2C bus. These are shared by the MD_DS1307T objects for all bus types.
+ */
+class MD_DS1307Base
+{
+  public:
+ //--------------------------------------------------------------
+ /** \name Miscellaneous methods
+  * @{
+  */
+ /**
+  * Calculate day of week for a given date
+  *
+  * Given the specified date, calculate the day of week.
+  * 
+  * \sa Wikipedia https://en.wikipedia.org/wiki/Determination_of_the_day_of_the_week
+  *
+  * \param yyyy  year for specified date. yyyy must be > 1752.
+  * \param mm    month for the specified date where mm is in the range [1..12], 1 = January.
+  * \param dd    date for the specified date in the range [1..31], where 1 = first day of the month.
+  * \return dow value calculated [1..7], where 1 = Sunday.
+  */
+  uint8_t calcDoW(uint16_t yyyy, uint8_t mm, uint8_t dd);
+
+ /** @} */
+
+ //--------------------------------------------------------------
+ /** \name Packed time methods
+  * @{
+  */
+ /**
+  * Calculate days since 1 Jan 2000 for a given date
+  *
+  * The calculation uses a March based year, so the leap day is the last day of
+  * each 4 year block, and needs no tables or loops. The function is constexpr
+  * and can be used to calculate constants at compile time.
+  *
+  * \param yyyy  year for the specified date, 2000 to 2099.
+  * \param mm    month for the specified date where mm is in the range [1..12], 1 = January.
+  * \param dd    date for the specified date in the range [1..31].
+  * \return the number of days since 1 Jan 2000.
+  */
+  static constexpr uint16_t daysFromCivil(uint16_t yyyy, uint8_t mm, uint8_t dd)
+  { return(daysFromMarch(yyyy - (mm <= 2) - 1996, mm > 2 ? mm - 3 : mm + 9, dd)); }
+
+ /**
+  * Calculate the date for a number of days since 1 Jan 2000
+  *
+  * This is the inverse of daysFromCivil().
+  *
+  * \param days  number of days since 1 Jan 2000, 0 to 36524.
+  * \param yyyy  receives the year.
+  * \param mm    receives the month [1..12].
+  * \param dd    receives the date [1..31].
+  */
+  static void civilFromDays(uint16_t days, uint16_t &yyyy, uint8_t &mm, uint8_t &dd);
+
+ /**
+  * Make a packed time
+  *
+  * Combine the date and 24 hour time into a packed time. The function is
+  * constexpr and can be used to calculate constants at compile time.
+  *
+  * \param yyyy  year, 2000 to 2099.
+  * \param mm    month [1..12].
+  * \param dd    date [1..31].
+  * \param h     hour in 24 hour format [0..23].
+  * \param m     minutes [0..59].
+  * \param s     seconds [0..59].
+  * \return the packed time.
+  */
+  static constexpr ds1307Time_t makeTime(uint16_t yyyy, uint8_t mm, uint8_t dd, uint8_t h = 0, uint8_t m = 0, uint8_t s = 0)
+  { return((daysFromCivil(yyyy, mm, dd) * 86400UL) + (h * 3600UL) + (m * 60U) + s); }
+
+ /**
+  * Add seconds to a packed time
+  *
+  * \param t     the packed time.
+  * \param secs  seconds to add, negative to subtract.
+  * \return the new packed time.
+  */
+  static inline ds1307Time_t timeAdd(ds1307Time_t t, int32_t secs) { return(t + secs); }
+
+ /**
+  * Difference between packed times
+  *
+  * \param t1  the first packed time.
+  * \param t2  the second packed time.
+  * \return the number of seconds from t2 to t1, negative if t1 is earlier.
+  */
+  static inline int32_t timeDiff(ds1307Time_t t1, ds1307Time_t t2) { return((int32_t)(t1 - t2)); }
+
+ /**
+  * Compare packed times
+  *
+  * \param t1  the first packed time.
+  * \param t2  the second packed time.
+  * \return -1 if t1 is earlier than t2, 0 if they are the same, 1 if t1 is later.
+  */
+  static inline int8_t timeCompare(ds1307Time_t t1, ds1307Time_t t2) { return((t1 > t2) - (t1 < t2)); }
+
+ /**
+  * Get the interface registers as a packed time
+  *
+  * Convert the yyyy, mm, dd, h, m, s and pm values last read from the RTC,
+  * or set by setTime(), into a packed time. No I2C traffic is generated.
+  *
+  * \return the packed time.
+  */
+  ds1307Time_t getTime(void);
+
+ /**
+  * Time field arrays for bulk conversion.
+  *
+  * Pointers to separate arrays for each time field, one element per time. 
+  * Hours are in 24 hour format and dow is [1..7], where 1 = Sunday.
+  */
+  struct timeArray_t
+  {
+    uint16_t *yyyy;   ///< Years
+    uint8_t *mm;      ///< Months [1..12]
+    uint8_t *dd;      ///< Dates [1..31]
+    uint8_t *h;       ///< Hours [0..23]
+    uint8_t *m;       ///< Minutes [0..59]
+    uint8_t *s;       ///< Seconds [0..59]
+    uint8_t *dow;     ///< Days of the week [1..7]
+  };
+
+ /**
+  * Convert an array of packed times to time fields
+  *
+  * Convert n packed times to the time field arrays. This is for large 
+  * numbers of times, such as when a log is exported. The loop has no 
+  * branches or tables, so compilers can vectorise it on processors with 
+  * SIMD instructions. No I2C traffic is generated.
+  *
+  * \param t  the packed times.
+  * \param n  the number of times.
+  * \param f  the field arrays, each with room for n elements. The arrays must not overlap each other or t.
+  */
+  static void civilFromTimes(const ds1307Time_t *t, size_t n, const timeArray_t &f);
+
+ /**
+  * Convert time field arrays to an array of packed times
+  *
+  * The inverse of civilFromTimes(). The dow array is not used and may be NULL.
+  *
+  * \param f  the field arrays, each with n elements.
+  * \param n  the number of times.
+  * \param t  receives the n packed times. This must not overlap the field arrays.
+  */
+  static void timesFromCivil(const timeArray_t &f, size_t n, ds1307Time_t *t);
+
+ /** @} */
+
+ //--------------------------------------------------------------
+ /** \name Text conversion methods
+  * @{
+  */
+ /**
+  * Format the interface registers as text
+  *
+  * Write the time in the interface registers into _buf_ as specified by the
+  * pattern, in one pass with no dynamic memory. Characters in the pattern are
+  * copied, except for these codes
+  * - %%Y year (4 digits, 2000 to 2099), %%y year (2 digits)
+  * - %%m month, %%d date, %%b month name (Jan-Dec)
+  * - %%H hour (24 hour), %%I hour (12 hour), %%p am or pm
+  * - %%M minutes, %%S seconds
+  * - %%a day of week name (Sun-Sat, dow 1 = Sunday)
+  * - %%%% a % character
+  *
+  * Numbers are written as 2 digits with a leading zero. The output is cut 
+  * short to fit the buffer and is always nul terminated. The hour codes 
+  * work in either hour mode.
+  *
+  * \sa DS1307_FMT_ISO and related pattern definitions
+  *
+  * \param buf  the receiving character buffer.
+  * \param len  size of the buffer, including the terminating nul.
+  * \param fmt  the pattern, by default DS1307_FMT_ISO.
+  * \return the number of characters written, excluding the terminating nul.
+  */
+  uint8_t format(char *buf, uint8_t len, const char *fmt = DS1307_FMT_ISO) { return(formatText(buf, len, fmt, false)); }
+
+ /**
+  * Format the interface registers as text, pattern in program memory
+  *
+  * As for format(), with the pattern in program memory, for example F("%H:%M").
+  *
+  * \param buf  the receiving character buffer.
+  * \param len  size of the buffer, including the terminating nul.
+  * \param fmt  the pattern in program memory.
+  * \return the number of characters written, excluding the terminating nul.
+  */
+  uint8_t format(char *buf, uint8_t len, const __FlashStringHelper *fmt) { return(formatText(buf, len, (const char *)fmt, true)); }
+
+ /**
+  * Set the interface registers from ISO 8601 text
+  *
+  * Parse a date and time in the form yyyy-mm-ddThh:mm:ss (the T may also be a 
+  * space) into the interface registers and calculate dow. h is set in 24 
+  * hour time with pm set for hours from 12, which writeTime() handles in either 
+  * hour mode. The interface registers are not changed if the text is not valid.
+  *
+  * \param str  the text to parse.
+  * \return true if the text was valid, false otherwise.
+  */
+  bool parseISO(const char *str);
+
+ /**
+  * Set the interface registers from the compiler build time
+  *
+  * As for parseISO(), with the date and time in the form of the compiler 
+  * __DATE__ ("Mmm dd yyyy") and __TIME__ ("hh:mm:ss") strings. This is an 
+  * easy way to set the RTC when the sketch is uploaded:
+  *
+  *     RTC.parseBuild(__DATE__, __TIME__);
+  *     RTC.writeTime();
+  *
+  * \param date  the date text.
+  * \param time  the time text.
+  * \return true if the text was valid, false otherwise.
+  */
+  bool parseBuild(const char *date, const char *time);
+
+ /** @} */
+
+ //--------------------------------------------------------------
+ /** \name Frame codec methods
+  * @{
+  */
+ /**
+  * Convert BCD to binary
+  *
+  * \param v  packed BCD value 0x00 to 0x99.
+  * \return the binary value.
+  */
+  static inline uint8_t BCD2bin(uint8_t v) { return(v - 6 * (v >> 4)); }
+
+ /**
+  * Convert binary to BCD
+  *
+  * The tens digit is found by multiplying by 205/2048, which is exact for
+  * 0 to 99 and avoids a division on processors without a hardware divider.
+  *
+  * \param v  binary value 0 to 99.
+  * \return the packed BCD value.
+  */
+  static inline uint8_t bin2BCD(uint8_t v) { return(v + 6 * ((v * 205U) >> 11)); }
+
+ /**
+  * Unpack a time frame
+  *
+  * Convert the 7 RTC time registers in _buf_ into the interface registers
+  * (yyyy, mm, dd, h, m, s, dow, pm), in the hour mode of the frame. No I2C 
+  * traffic is generated.
+  *
+  * \param buf  the time registers, RTC address 0 first.
+  */
+  void unpackTime(const uint8_t *buf);
+
+ /**
+  * Pack a time frame
+  *
+  * Convert the interface registers into the 7 RTC time registers in _buf_. 
+  * 12 hour register values come from a lookup table in program memory. In 12
+  * hour mode h is taken as 24 hour time if it is greater than 12, otherwise pm 
+  * selects AM or PM. No I2C traffic is generated.
+  *
+  * \param buf     receives the time registers, RTC address 0 first.
+  * \param mode12  true to pack the hours in 12 hour mode.
+  */
+  void packTime(uint8_t *buf, bool mode12);
+
+ /** @} */
+
+ //--------------------------------------------------------------
+ /** \name Public variables for reading and writing time data
+  * @{
+  */
+  uint16_t yyyy;///< Year including the century.
+  uint8_t mm;   ///< Month (1-12)
+  uint8_t dd;   ///< Date of the month (1-31)
+  uint8_t h;    ///< Hour of the day (1-12) or (0-23) depending on the am/pm or 24h mode setting
+  uint8_t m;    ///< Minutes past the hour (0-59)
+  uint8_t s;    ///< Seconds past the minute (0-59)
+  uint8_t dow;  ///< Day of the week (1-7). Sequential number; day coding depends on the application and zero is an undefined value
+  uint8_t pm;   ///< Non-zero if 12 hour clock mode and PM, always zero for 24 hour clock. Check the time and if < 12 then check this indicator. Also an input to writeTime(), see there.
+
+  /** @} */
+
+protected:
+  MD_DS1307Base(void);
+
+  // Device address and register map
+  static constexpr uint8_t DS1307_ID = 0x68;    // I2C/TWI device address, coded into the device
+  static constexpr uint8_t RAM_BASE_READ = 0;   // smallest read address
+  static constexpr uint8_t RAM_BASE_WRITE = 8;  // smallest write address
+
+  // Addresses for the parts of the date/time in RAM
+  static constexpr uint8_t ADDR_SEC = 0x0;
+  static constexpr uint8_t ADDR_MIN = 0x1;
+  static constexpr uint8_t ADDR_HR = 0x2;
+  static constexpr uint8_t ADDR_DAY = 0x3;
+  static constexpr uint8_t ADDR_DATE = 0x4;
+  static constexpr uint8_t ADDR_MON = 0x5;
+  static constexpr uint8_t ADDR_YR = 0x6;
+
+  // Address for the special control bytes
+  static constexpr uint8_t ADDR_CTL_CH = 0x0;
+  static constexpr uint8_t ADDR_CTL_12H = 0x2;
+  static constexpr uint8_t ADDR_CTL_OUT = 0x7;
+  static constexpr uint8_t ADDR_CTL_SQWE = 0x7;
+  static constexpr uint8_t ADDR_CTL_RS = 0x7;
+
+  // Bit masks for the control/testable bits
+  static constexpr uint8_t CTL_CH = 0x80;
+  static constexpr uint8_t CTL_12H = 0x40;
+  static constexpr uint8_t CTL_PM = 0x20;
+  static constexpr uint8_t CTL_OUT = 0x80;
+  static constexpr uint8_t CTL_SQWE = 0x10;
+  static constexpr uint8_t CTL_RS = 0x03;
+
+  bool _mode12;   // hour mode of the time fields, true for 12 hour
+
+  // Time frame and calendar helpers
+  void advance(uint32_t secs, bool mode12);
+  uint8_t daysInMonth(uint16_t yyyy, uint8_t mm);
+  uint8_t convertHour(uint8_t v, bool to12);
+  bool fieldRange(uint8_t fields, uint8_t &lo, uint8_t &hi);
+  void saveFields(uint8_t *prev);
+  uint8_t hour24(void);
+  uint8_t formatText(char *buf, uint8_t len, const char *fmt, bool progmem);
+  bool setCivil(uint16_t y, uint16_t mo, uint16_t d, uint16_t hr, uint16_t mi, uint16_t se);
+  uint8_t changedFields(const uint8_t *prev);
+  bool frameValid(const uint8_t *buf);
+
+  // Packed time conversion helpers
+  static constexpr uint16_t daysFromMarch(uint16_t yy, uint8_t mp, uint8_t dd)
+  { return((365U * yy) + (yy / 4) + ((153U * mp + 2) / 5) + dd - 1 - 1401); }  // yy years and mp months from 1 Mar 1996
+  void unpackSeconds(ds1307Time_t t, bool mode12);
+};
+
 /**
  * Core object for the MD_DS1307 library
+ *
+ * The I2C transport is the template parameter Bus. This can be the Arduino 
+ * TwoWire class, a software I2C implementation or a test double, as long as it 
+ * provides the TwoWire methods used by the library: begin(), beginTransmission(), 
+ * write(), endTransmission(), requestFrom() and read(). The bus is resolved at 
+ * compile time, so there are no virtual calls. Each object has its own buffers,
+ * so several RTCs can be used on separate buses.
+ *
+ * MD_DS1307 is the type for the hardware Wire library.
+ *
+ * \tparam Bus the I2C bus class.
  */
-class MD_DS1307
+template <class Bus>
+class MD_DS1307T : public MD_DS1307Base
 {
   public:
+ /**
+  * Bus statistics record.
+  *
+  * Accumulated I2C bus usage for one of the public operations. The bus time 
+  * is an estimate for a 100kHz bus clock, counting 9 clock periods per byte 
+  * (8 data bits and ACK) plus the START and STOP conditions.
+  *
+  * The call times are measured with micros() and counted in a histogram, 
+  * with bucket i counting calls taking less than DS1307_STATS_BUCKET_US << i 
+  * microseconds. For the asynchronous methods the time is from the begin 
+  * call to the completion of the operation in poll().
+  */
+  struct busStats_t
+  {
+    uint32_t calls;   ///< Number of calls to the method
+    uint32_t trans;   ///< Number of I2C transactions (START to STOP)
+    uint32_t bytes;   ///< Number of bytes on the wire, including device and register addresses
+    uint32_t busTime; ///< Estimated bus time in microseconds
+    uint32_t nacks;   ///< Number of transactions not acknowledged or failed on the bus
+    uint32_t shortReads; ///< Number of reads that returned fewer bytes than requested
+    uint32_t latency[DS1307_STATS_BUCKETS]; ///< Histogram of call times
+  };
+
  /** 
   * Class Constructor
   *
-  * Instantiate a new instance of the class. One instance of the class is 
-  * created in the libraries as the RTC object.
+  * Instantiate a new instance of the class on the I2C bus object supplied. 
+  * One instance of the class is created in the libraries as the RTC object.
+  * The bus is not started here, as the constructor of a global object runs 
+  * before setup(), but by begin().
   * 
+  * \param bus  the I2C bus object, by default the Arduino Wire object.
   */
-  MD_DS1307();
+  MD_DS1307T(Bus &bus = Wire);
 
   /**
-  * Overloaded Class Constructor (ESP8266 only)
+  * Overloaded Class Constructor
   *
   * Provides a way to assign custom SCL and SDA pins if the architecture
-  * supports them.
+  * supports them (eg, ESP8266). Only usable with bus types that provide 
+  * begin(sda, scl).
   *
   * \param sda  Pin number for the SDA signal
   * \param scl  Pin number for the SCL signal
+  * \param bus  the I2C bus object, by default the Arduino Wire object.
   */
-  MD_DS1307(int sda, int scl);
+  MD_DS1307T(int sda, int scl, Bus &bus = Wire);
 
   //--------------------------------------------------------------
  /** \name Methods for object and hardware control.
   * @{
   */
+ /**
+  * Start the RTC and check its state.
+  *
+  * Start the I2C bus and read the time and control registers, together with 
+  * an optional header at the start of the battery backed RAM (address 8), 
+  * as one block. The register pointer is set once and the block read in one
+  * transaction, or in back to back transactions of DS1307_BUS_BUFFER bytes 
+  * when the header makes it longer than that. The time is unpacked into the 
+  * interface registers, anchoring the soft clock unless the time is not valid,
+  * and the control register cache is loaded, so at startup this replaces 
+  * separate isRunning(), readTime() and readRAM() calls.
+  *
+  * The header is copied to hdr and its first sigLen bytes compared with the 
+  * signature sig, allowing an application to check that the RAM holds its 
+  * own data.
+  *
+  * begin() must be called in setup() before the RTC is used, as it is the 
+  * only place the bus is started. It calls the bus begin() each time, so 
+  * bus settings such as the clock speed should be made after it.
+  *
+  * \param hdr     buffer for the RAM header, NULL if none is needed.
+  * \param len     the number of header bytes to read, up to DS1307_RAM_MAX-8.
+  * \param sig     the signature expected at the start of the header, NULL if none.
+  * \param sigLen  the number of signature bytes, up to len.
+  * \return the DS1307_BOOT_* flags for the problems found, ORed together, or DS1307_BOOT_OK.
+  */
+  uint8_t begin(uint8_t *hdr = NULL, uint8_t len = 0, const uint8_t *sig = NULL, uint8_t sigLen = 0);
+
  /** 
   * Set the control status of the specified parameter to the specified value.
   * 
@@ -222,6 +891,109 @@ class MD_DS1307
   */
   uint8_t status(uint8_t item);
 
+ /** 
+  * Set the control status of the specified parameter, resolved at compile time.
+  * 
+  * As for control(), with the item and value as template parameters, for example
+  * control<DS1307_SQW_RUN, DS1307_ON>(). The register address, mask and command 
+  * bits are worked out by the compiler, leaving only the register update in the 
+  * code. An invalid combination of item and value fails to compile.
+  *
+  * \tparam item    one of the defined code request values.
+  * \tparam value   value as one of the defined code status values.
+  */
+  template <uint8_t item, uint8_t value> void control(void);
+
+ /**
+  * Obtain the current setting for the specified parameter, resolved at compile time.
+  * 
+  * As for status(), with the item as a template parameter, for example 
+  * status<DS1307_12H>(). Only the register holding the item is read from the 
+  * RTC, or it is taken from the cache if enabled. An invalid item fails to compile.
+  *
+  * \tparam item  one of the defined control request values.
+  * \return one of the defined code status values.
+  */
+  template <uint8_t item> uint8_t status(void);
+
+#if DS1307_CONTROL_BATCH
+ /**
+  * Start a batch of control changes.
+  *
+  * After this call control() queues the changes instead of applying them. The 
+  * changes are merged per device register and applied by commitControl() with 
+  * one read and one write for each register touched. The 12/24H hour conversion 
+  * is applied as for an individual control() call.
+  *
+  * \sa commitControl(), control() methods
+  */
+  void beginControl(void);
+
+ /**
+  * Apply a batch of control changes.
+  *
+  * Write the control changes queued since beginControl() to the device, and 
+  * return to applying control() changes immediately.
+  *
+  * \sa beginControl(), control() methods
+  */
+  void commitControl(void);
+#endif
+
+ /**
+  * Enable or disable the control register cache.
+  *
+  * When the cache is enabled the library keeps a copy of the control register 
+  * and the clock halt and 12 hour mode bits. status() is then answered from 
+  * memory without any I2C traffic and control() writes through to the device, 
+  * skipping the read for the control register. The cache is loaded by the first 
+  * status() or refresh() call after it is enabled and kept up to date by 
+  * readTime(), writeTime() and control().
+  *
+  * If another bus master can change the device registers, use invalidate() 
+  * or refresh() to resynchronize the cache.
+  *
+  * \sa refresh(), invalidate(), getCacheStats() methods
+  *
+  * \param b   true to enable the cache, false to disable it.
+  */
+  void enableCache(bool b = true) { _cacheOn = b; _cacheValid = false; }
+
+ /**
+  * Reload the control register cache.
+  *
+  * Read the control registers from the device and load them into the cache.
+  *
+  * \sa enableCache(), invalidate() methods
+  */
+  void refresh(void);
+
+ /**
+  * Invalidate the control register cache.
+  *
+  * Mark the cache contents as stale. The next status() call will read the 
+  * registers from the device.
+  *
+  * \sa enableCache(), refresh() methods
+  */
+  void invalidate(void) { _cacheValid = false; _shadowKnown = 0; }
+
+#if DS1307_BUS_STATS
+ /**
+  * Get the cache hit and miss counts.
+  *
+  * Return the number of status() calls answered from the cache (hits) and the
+  * number that needed a device read (misses) while the cache was enabled. 
+  * The counts are kept with the bus statistics.
+  *
+  * \sa enableCache() method
+  *
+  * \param hits    receives the number of cache hits.
+  * \param misses  receives the number of cache misses.
+  */
+  void getCacheStats(uint32_t &hits, uint32_t &misses) { hits = _cacheHits; misses = _cacheMisses; }
+#endif
+
   /** @} */
 
  //--------------------------------------------------------------
@@ -235,9 +1007,18 @@ class MD_DS1307
   * Query the RTC for the current time and load that into the library interface registers 
   * (yyyy, mm, dd, h, m, s, dow, pm) from which the data can be accessed.
   *
-  * \return false if errors, true otherwise.
+  * If the soft clock is enabled the time is calculated from millis() and the last 
+  * time read from the RTC, and the RTC is only read when the resync interval has expired.
+  *
+  * The return value shows which interface registers changed value, so that 
+  * display or logging code only needs to update those fields. Zero means 
+  * nothing changed.
+  *
+  * \sa softClock() method
+  *
+  * \return the DS1307_FLD_* values for the fields that changed, ORed together.
   */
-  void readTime(void);
+  uint8_t readTime(void);
 
  /**
   * Write the current time from the interface registers
@@ -245,8 +1026,43 @@ class MD_DS1307
   * Write the data in the interface registers (yyyy, mm, dd, h, m, s, dow, pm) 
   * as the current time in the RTC.
   *
+  * Only the fields selected are written, as one transaction covering the 
+  * contiguous range of RTC registers from the first to the last field selected.
+  * For example, a drift correction that only changes the seconds is written as 
+  * a single register. Writing the seconds restarts the current second and 
+  * also starts the clock if it is halted.
+  *
+  * In 12 hour mode h is taken as 24 hour time if it is greater than 12, otherwise 
+  * pm selects AM or PM. pm is an input like h. It keeps the value from the last 
+  * readTime() unless it is set, so set pm whenever h is set. Setting h as 24 
+  * hour time with pm = (h >= 12) is correct in either hour mode. The interface
+  * registers are not changed. The hour mode is remembered from the last RTC 
+  * access, so the RTC is only queried for it if it is not known.
+  *
+  * \param fields  the DS1307_FLD_* values for the fields to write, ORed together.
+  */
+  void writeTime(uint8_t fields = DS1307_FLD_ALL);
+
+ /**
+  * Read the current time as a packed time
+  *
+  * As for readTime(), and also return the time as seconds since 1 Jan 2000.
+  *
+  * \param t  receives the packed time.
+  */
+  void readTime(ds1307Time_t &t) { readTime(); t = getTime(); }
+
+ /**
+  * Set the interface registers from a packed time
+  *
+  * Set yyyy, mm, dd, h, m, s, dow and pm from the packed time in the current 
+  * hour mode of the RTC. Use writeTime() to write them to the RTC. The hour 
+  * mode is remembered from the last RTC access, so the RTC is only queried 
+  * for it if it is not known.
+  *
+  * \param t  the packed time.
   */
-  void writeTime(void);
+  void setTime(ds1307Time_t t);
 
  /**
  * Compatibility function - Read the current time
@@ -270,8 +1086,257 @@ class MD_DS1307
   */
   boolean isRunning(void) { return(status(DS1307_CLOCK_HALT) != DS1307_ON); }
 
+#if DS1307_SOFT_CLOCK
+ /**
+  * Enable or disable the soft clock
+  *
+  * In soft clock mode readTime() anchors to one read of the RTC and then advances 
+  * the time locally using millis(), including day, month and leap year rollovers. 
+  * The RTC is read again once the resync interval has expired or when resync() 
+  * is called. Time reported between reads is accurate to within one second of 
+  * the RTC, plus the drift of the processor clock over the resync interval.
+  *
+  * A writeTime() reanchors the soft clock, as writing the time restarts the 
+  * RTC second. A halted clock is not extrapolated.
+  *
+  * \sa resync(), readTime() methods
+  *
+  * \param b       true to enable the soft clock, false to disable it.
+  * \param resync  the maximum time in seconds between RTC reads.
+  */
+  void softClock(bool b, uint32_t resync = 3600);
+
+ /**
+  * Resynchronize the soft clock
+  *
+  * Read the current time from the RTC into the interface registers and reanchor 
+  * the soft clock to it.
+  *
+  * \sa softClock() method
+  */
+  void resync(void) { _softValid = false; readTime(); }
+#endif
+
+#if DS1307_SQW_TICK
+ /**
+  * Start the SQW interrupt tick mode
+  *
+  * Configure the square wave output to run at 1Hz and attach an interrupt to
+  * the falling edge of the signal on the specified pin. The SQW/OUT pin is 
+  * open drain, so the pin is set up with the internal pull-up enabled. The time 
+  * is read once from the RTC and from then on each interrupt counts one second. 
+  * readTime() and tickCheck() apply the counted seconds to the interface 
+  * registers without any further I2C reads.
+  *
+  * Only one object can use tick mode at any time, as the interrupt handler 
+  * is shared.
+  *
+  * \sa tickEnd(), tickCheck(), setTickCallback() methods
+  *
+  * \param pin   the processor pin connected to the RTC SQW/OUT pin.
+  * \return false if the pin does not support interrupts or the RTC could not be read, true otherwise.
+  */
+  bool tickBegin(uint8_t pin);
+
+ /**
+  * Start the SQW high resolution time mode
+  *
+  * Configure the square wave output to run at one of the kHz frequencies and
+  * count the falling edges in an interrupt on the specified pin. The count is 
+  * zeroed at an RTC second boundary, found by polling the seconds register, so 
+  * the edges count both the seconds and the fraction of a second using the RTC 
+  * crystal as the timebase. The polling blocks for up to 1.1 seconds, with the 
+  * I2C bus busy throughout. It is repeated whenever the anchor is lost in this 
+  * mode, which is by writeTime() of only some fields and by control() of 
+  * DS1307_CLOCK_HALT or DS1307_12H. This works as
+  * tick mode for readTime() and tickCheck(), and readTimeFine() also returns 
+  * the fraction of the current second.
+  *
+  * The interrupt load is significant at the higher frequencies. On 8 bit AVR 
+  * processors DS1307_SQW_4KHZ is the practical choice. readTime() or 
+  * readTimeFine() should be called at least every 36 hours at DS1307_SQW_32KHZ 
+  * to avoid overflowing the edge counter.
+  *
+  * \sa tickEnd(), readTimeFine() methods
+  *
+  * \param pin   the processor pin connected to the RTC SQW/OUT pin.
+  * \param freq  one of DS1307_SQW_4KHZ, DS1307_SQW_8KHZ or DS1307_SQW_32KHZ.
+  * \return false if the pin does not support interrupts, the frequency is invalid or the RTC could not be read, true otherwise.
+  */
+  bool fineBegin(uint8_t pin, uint8_t freq = DS1307_SQW_4KHZ);
+
+ /**
+  * Read the current time with a sub-second fraction
+  *
+  * As for readTime(), and also return the fraction of the current second counted
+  * from the SQW edges in high resolution mode. The resolution is that of the SQW 
+  * frequency selected. If high resolution mode is not running the fraction is 0.
+  *
+  * \sa fineBegin(), readTime() methods
+  *
+  * \param frac  receives the fraction of the second in units of 1/65536 second.
+  */
+  void readTimeFine(uint16_t &frac);
+
+ /**
+  * Stop the SQW interrupt tick or high resolution mode
+  *
+  * Detach the interrupt and return to reading the time from the RTC. The square 
+  * wave output is left running.
+  *
+  * \sa tickBegin(), fineBegin() methods
+  */
+  void tickEnd(void);
+
+ /**
+  * Check for elapsed seconds in tick mode
+  *
+  * Apply any seconds counted by the interrupt handler to the interface registers
+  * and report whether at least one second has elapsed since the last call. 
+  * If a callback function has been set, it is invoked when a second has elapsed. 
+  * The callback runs in the context of the caller, not in the interrupt.
+  *
+  * \sa tickBegin(), setTickCallback() methods
+  *
+  * \return true if one or more seconds have elapsed since the last call.
+  */
+  bool tickCheck(void);
+
+ /**
+  * Set the tick callback function
+  *
+  * The callback function is invoked by tickCheck() when one or more seconds 
+  * have elapsed in tick mode.
+  *
+  * \sa tickCheck() method
+  *
+  * \param cb  the address of the callback function, NULL to remove the callback.
+  */
+  void setTickCallback(void (*cb)(void)) { _tickCallback = cb; }
+#endif
+
   /** @} */
 
+#if DS1307_ASYNC
+ //--------------------------------------------------------------
+ /** \name Methods for non-blocking operations
+  * 
+  * The I2C library blocks for the whole of each transaction. These methods split 
+  * an operation into steps of at most one short transaction, run one at a time 
+  * by poll() from the main loop. Only one asynchronous operation can run at any 
+  * time and other RTC methods should not be used while it runs, as they move 
+  * the RTC register pointer.
+  *
+  * The DS1307 latches the time registers at the start of each read, so the 
+  * time is always read as one transaction to avoid mixing values from either 
+  * side of a second rollover.
+  * @{
+  */
+
+ /**
+  * Start an asynchronous time read
+  *
+  * As for readTime(), but the read is run by poll(). The interface registers 
+  * are updated when the operation completes. In soft clock or tick mode the 
+  * operation completes on the next poll() without any I2C traffic, unless the 
+  * soft clock needs a resync.
+  *
+  * \sa poll(), readTime() methods
+  *
+  * \return false if another operation is running, true otherwise.
+  */
+  bool beginReadTime(void);
+
+ /**
+  * Start an asynchronous time write
+  *
+  * As for writeTime(), but the write is run by poll(). The interface registers
+  * are packed when the time is sent and should not be changed before the 
+  * operation completes.
+  *
+  * \sa poll(), writeTime() methods
+  *
+  * \param fields  the DS1307_FLD_* values for the fields to write, ORed together.
+  * \return false if another operation is running or no fields are selected, true otherwise.
+  */
+  bool beginWriteTime(uint8_t fields = DS1307_FLD_ALL);
+
+ /**
+  * Start an asynchronous RAM read
+  *
+  * As for readRAM(), but the read is run by poll() in chunks of DS1307_ASYNC_CHUNK 
+  * bytes. The buffer must remain valid until the operation completes.
+  *
+  * \sa poll(), readRAM() methods
+  *
+  * \param addr    starting address for the read.
+  * \param buf     address of the receiving byte buffer.
+  * \param len     number of bytes to read.
+  * \return false if another operation is running or the parameters are invalid, true otherwise.
+  */
+  bool beginReadRAM(uint8_t addr, uint8_t* buf, uint8_t len);
+
+ /**
+  * Start an asynchronous RAM write
+  *
+  * As for writeRAM(), but the write is run by poll() in chunks of DS1307_ASYNC_CHUNK
+  * bytes. The buffer must remain valid until the operation completes.
+  *
+  * \sa poll(), writeRAM() methods
+  *
+  * \param addr    starting address for the write.
+  * \param buf     address of the data buffer.
+  * \param len     number of bytes to write.
+  * \return false if another operation is running or the parameters are invalid, true otherwise.
+  */
+  bool beginWriteRAM(uint8_t addr, uint8_t* buf, uint8_t len);
+
+ /**
+  * Run the asynchronous operation
+  *
+  * Move the current asynchronous operation on by one step. This should be called 
+  * from the main loop until it returns true. When the operation completes the 
+  * callback function, if set, is invoked with the operation and the number of 
+  * bytes transferred.
+  *
+  * \sa isBusy(), getAsyncCount(), setAsyncCallback() methods
+  *
+  * \return true if the operation completed in this call, false otherwise.
+  */
+  bool poll(void);
+
+ /**
+  * Check if an asynchronous operation is running
+  *
+  * \return true if an asynchronous operation is running, false otherwise.
+  */
+  bool isBusy(void) { return(_asyncState != ASYNC_IDLE); }
+
+ /**
+  * Get the byte count for the last asynchronous operation
+  *
+  * Once an operation has completed, a count less than the requested length 
+  * shows that it failed. For time operations the length is the number of 
+  * time registers transferred.
+  *
+  * \return the number of bytes transferred.
+  */
+  uint8_t getAsyncCount(void) { return(_asyncCount); }
+
+ /**
+  * Set the asynchronous operation callback function
+  *
+  * The callback function is invoked by poll() when an operation completes. The 
+  * parameters are the DS1307_OP_* operation identifier and the number of bytes 
+  * transferred.
+  *
+  * \param cb  the address of the callback function, NULL to remove the callback.
+  */
+  void setAsyncCallback(void (*cb)(uint8_t op, uint8_t count)) { _asyncCallback = cb; }
+
+  /** @} */
+#endif
+
  //--------------------------------------------------------------
  /** \name Miscellaneous methods
   * @{
@@ -280,10 +1345,11 @@ class MD_DS1307
   * Read the raw RTC clock data
   *
   * Read _len_ bytes from the RTC clock starting at _addr_ as raw data into the 
-  * buffer supplied. The size of the buffer should be at least MAX_BUF bytes long 
-  * (defined in the library cpp file).
+  * buffer supplied. The size of the buffer should be at least _len_ bytes long.
+  * Reads longer than the I2C library buffer (DS1307_BUS_BUFFER) are done as 
+  * back to back chunks after setting the start address once.
   * 
-  * Read address starts at 0.
+  * Read address starts at 0 and addr + len must not exceed DS1307_RAM_MAX.
   *
   * \sa writeRAM() method
   *
@@ -300,7 +1366,9 @@ class MD_DS1307
   * Write _len_ bytes of data in the buffer supplied to the RTC clock starting at _addr_.
   * The size of the buffer should be at least _len_ bytes long.
   *
-  * Write address starts at 8 (first 7 bytes are for clock registers).
+  * Write address starts at 8 (first 7 bytes are for clock registers) and 
+  * addr + len must not exceed DS1307_RAM_MAX. Writes longer than the I2C 
+  * library buffer are split into several transactions.
   *
   * \sa readRAM() method
   *
@@ -312,49 +1380,215 @@ class MD_DS1307
   uint8_t writeRAM(uint8_t addr, uint8_t* buf, uint8_t len);
 
  /**
-  * Calculate day of week for a given date
+  * Read the whole RTC register file
   *
-  * Given the specified date, calculate the day of week.
-  * 
-  * \sa Wikipedia https://en.wikipedia.org/wiki/Determination_of_the_day_of_the_week
+  * Read all DS1307_RAM_MAX registers (clock, control and battery backed RAM) into
+  * the buffer supplied, in the fewest transactions the I2C library allows. 
+  * The buffer must be at least DS1307_RAM_MAX bytes long.
   *
-  * \param yyyy  year for specified date. yyyy must be > 1752.
-  * \param mm    month for the specified date where mm is in the range [1..12], 1 = January.
-  * \param dd    date for the specified date in the range [1..31], where 1 = first day of the month.
-  * \return dow value calculated [1..7], where 1 = Sunday.
+  * \sa restoreRAM(), readRAM() methods
+  *
+  * \param buf  address of the receiving byte buffer.
+  * \return number of bytes successfully read.
   */
-  uint8_t calcDoW(uint16_t yyyy, uint8_t mm, uint8_t dd);
+  uint8_t dumpRAM(uint8_t* buf);
 
- /** @} */
+ /**
+  * Restore the battery backed RAM
+  *
+  * Write the battery backed RAM part (address 8 onwards) of a register file image, 
+  * as read by dumpRAM(), back to the RTC. The clock and control registers in the 
+  * image are not written.
+  *
+  * \sa dumpRAM(), writeRAM() methods
+  *
+  * \param buf  address of the DS1307_RAM_MAX byte register file image.
+  * \return number of bytes successfully written.
+  */
+  uint8_t restoreRAM(uint8_t* buf);
 
- //--------------------------------------------------------------
- /** \name Public variables for reading and writing time data
-  * @{
+#if DS1307_BUS_STATS
+ /**
+  * Get the bus statistics for an operation
+  *
+  * Copy the accumulated I2C bus statistics for the specified operation into 
+  * the structure supplied. Only available if DS1307_BUS_STATS is set to 1.
+  *
+  * \sa resetBusStats() method
+  *
+  * \param op      one of the DS1307_OP_* operation identifiers.
+  * \param stats   structure to receive the statistics.
+  * \return false if the operation identifier is invalid, true otherwise.
   */
-  uint16_t yyyy;///< Year including the century.
-  uint8_t mm;   ///< Month (1-12)
-  uint8_t dd;   ///< Date of the month (1-31)
-  uint8_t h;    ///< Hour of the day (1-12) or (0-23) depending on the am/pm or 24h mode setting
-  uint8_t m;    ///< Minutes past the hour (0-59)
-  uint8_t s;    ///< Seconds past the minute (0-59)
-  uint8_t dow;  ///< Day of the week (1-7). Sequential number; day coding depends on the application and zero is an undefined value
-  uint8_t pm;   ///< Non-zero if 12 hour clock mode and PM, always zero for 24 hour clock. Check the time and if < 12 then check this indicator.
+  bool getBusStats(uint8_t op, busStats_t &stats);
+
+ /**
+  * Reset the bus statistics
+  *
+  * Clear the accumulated I2C bus statistics for all operations. 
+  * Only available if DS1307_BUS_STATS is set to 1.
+  *
+  * \sa getBusStats() method
+  */
+  void resetBusStats(void);
+#endif
+
+ /** @} */
 
-  /** @} */
 
 private:
-  // BCD to binary number packing/unpacking functions
-  inline uint8_t BCD2bin(uint8_t v) { return v - 6 * (v >> 4); };
-  inline uint8_t bin2BCD (uint8_t v) { return v + 6 * (v / 10); };
+  Bus &_bus;        // the I2C bus the RTC is connected to
+  uint8_t _buf[8];  // transfer buffer, the time message (7 bytes) is the biggest we handle
+
+  // Bus start, done by begin()
+  int _sda, _scl;   // pins for the bus, if set by the constructor
+  void (*_busStart)(Bus &bus, int sda, int scl);  // starts the bus, called by begin()
+
+  static void busDefault(Bus &bus, int sda, int scl);
+  static void busPins(Bus &bus, int sda, int scl);
 
   // Interface functions for the RTC device
+  bool setPointer(uint8_t addr);
+  uint8_t readBlock(uint8_t* buf, uint8_t len);
   uint8_t readDevice(uint8_t addr, uint8_t* buf, uint8_t len);
   uint8_t writeDevice(uint8_t addr, uint8_t* buf, uint8_t len);
   
   // Functions to Initialize the class internal variables
   void init(void);
+
+  // Time register transfers
+  uint8_t updateTime(void);
+  bool readClock(void);
+  void acceptTime(const uint8_t *buf, bool valid);
+  void timeWritten(const uint8_t *buf, uint8_t lo, uint8_t hi);
+  void anchorLost(void);
+  bool hourMode(void);
+
+  // Shadow copies of the control bits
+  bool _cacheOn;        // cache is enabled
+  bool _cacheValid;     // shadow registers hold the device values
+  uint8_t _shadowCtl;   // copy of the control register
+  uint8_t _shadowFlags; // copy of the CH and 12H bits
+  uint8_t _shadowKnown; // CH and 12H bits that have been read or written
+
+  void updateShadow(uint8_t addr, uint8_t v);
+  void loadShadow(void);
+  void cacheCheck(void);
+
+  // Control actions
+  static constexpr bool ctlValid(uint8_t item, uint8_t value);
+  static constexpr uint8_t ctlAddr(uint8_t item);
+  static constexpr uint8_t ctlBits(uint8_t item);
+  static constexpr uint8_t ctlCmd(uint8_t item, uint8_t value);
+  static constexpr uint8_t statusDecode(uint8_t item, uint8_t v);
+  void controlSet(uint8_t item, uint8_t value, uint8_t addr, uint8_t mask, uint8_t cmd);
+  void controlWrite(uint8_t addr, uint8_t mask, uint8_t cmd, uint8_t mode12);
+  uint8_t readControl(uint8_t addr);
+
+#if DS1307_CONTROL_BATCH
+  // Control batching
+  bool _batchOn;          // control() changes are being queued
+  static constexpr uint8_t BATCH_SLOTS = 3;  // registers a batch can touch (CH, 12H and control)
+  uint8_t _batchMask[BATCH_SLOTS];  // merged masks for the CH, 12H and control registers
+  uint8_t _batchCmd[BATCH_SLOTS];   // merged command bits for the same registers
+  uint8_t _batch12H;      // queued DS1307_12H value, 0 if none
+
+  uint8_t batchIndex(uint8_t addr);
+#endif
+
+#if DS1307_SOFT_CLOCK || DS1307_SQW_TICK
+  // Soft clock and tick mode anchor
+  uint8_t _anchor[7];     // time registers at the anchor point
+#endif
+
+#if DS1307_SOFT_CLOCK
+  // Soft clock
+  bool _softOn;           // soft clock is enabled
+  bool _softValid;        // the anchor is valid
+  uint32_t _softMillis;   // millis() at the anchor point
+  uint32_t _softResync;   // resync interval in milliseconds
+
+  bool softCurrent(void);
+#endif
+
+#if DS1307_SQW_TICK
+  // SQW interrupt tick mode
+  int _tickIntr;                  // interrupt number in use, -1 if tick mode is off
+  bool _tickFlag;                 // seconds have elapsed since the last tickCheck()
+  void (*_tickCallback)(void);    // tickCheck() callback function
+  volatile uint32_t _sqwEdges;    // edges counted by the interrupt handler
+  uint8_t _sqwShift;              // log2 of SQW edges per second
+  static MD_DS1307T *_sqwInstance;// object serviced by the interrupt handler
+
+  static void sqwISR(void);
+  bool sqwBegin(uint8_t pin, uint8_t freq);
+  uint16_t applyTicks(void);
+  bool tickSync(void);
+#endif
+
+#if DS1307_ASYNC
+  // Asynchronous operation states
+  static constexpr uint8_t ASYNC_IDLE = 0;    // nothing to do
+  static constexpr uint8_t ASYNC_LOCAL = 1;   // time from the soft clock or tick mode, no I2C
+  static constexpr uint8_t ASYNC_MODE = 2;    // read the hour mode
+  static constexpr uint8_t ASYNC_POINTER = 3; // set the register pointer
+  static constexpr uint8_t ASYNC_READ = 4;    // read the next chunk
+  static constexpr uint8_t ASYNC_WRITE = 5;   // write the next chunk
+
+  // Asynchronous RAM chunk, leaving room for the register address in the bus buffer
+  static constexpr uint8_t ASYNC_CHUNK = (DS1307_ASYNC_CHUNK < DS1307_BUS_BUFFER ? DS1307_ASYNC_CHUNK : DS1307_BUS_BUFFER - 1);
+
+  // Asynchronous operations
+  uint8_t _asyncState;    // current step of the operation
+  uint8_t _asyncOp;       // DS1307_OP_* for the operation
+  uint8_t _asyncAddr;     // starting register address
+  uint8_t *_asyncBuf;     // data buffer
+  uint8_t _asyncLen;      // number of bytes to transfer
+  uint8_t _asyncChunk;    // maximum bytes per step
+  uint8_t _asyncCount;    // bytes transferred so far
+  uint8_t _asyncFrame[7]; // time registers for time operations
+  void (*_asyncCallback)(uint8_t op, uint8_t count);  // completion callback
+
+  bool asyncStart(uint8_t op, uint8_t state, uint8_t addr, uint8_t* buf, uint8_t len, uint8_t chunk);
+  bool pollStep(void);
+#endif
+
+#if DS1307_BUS_STATS
+  // Bus usage accounting
+  busStats_t _stats[DS1307_OP_COUNT]; // statistics per operation
+  uint8_t _statOp;                    // operation currently being accounted
+  uint32_t _cacheHits;                // status() requests answered from the cache
+  uint32_t _cacheMisses;              // status() requests needing a device read
+#if DS1307_ASYNC
+  uint32_t _asyncMicros;              // micros() at the start of the asynchronous operation
+#endif
+
+  void countBus(uint8_t trans, uint8_t bytes);
+  uint8_t statStart(uint8_t op);
+  void statTime(uint32_t t);
+
+  // Times a public operation from its start to the end of the scope
+  class statScope
+  {
+    public:
+    statScope(MD_DS1307T &rtc, uint8_t op) : _rtc(rtc), _prev(rtc.statStart(op)), _start(micros()) {}
+    ~statScope() { _rtc.statTime(micros() - _start); _rtc._statOp = _prev; }
+
+    private:
+    MD_DS1307T &_rtc;   // object being accounted
+    uint8_t _prev;      // operation being accounted before this one
+    uint32_t _start;    // micros() at the start of the operation
+  };
+#endif
 };
 
+#include "MD_DS1307_lib.h"
+
+/**
+ * The MD_DS1307 object using the Arduino hardware I2C (Wire) library.
+ */
+typedef MD_DS1307T<TwoWire> MD_DS1307;
+
 #ifndef ARDUINO_ARCH_SAMD
 extern MD_DS1307 RTC;     ///< Library created instance of the RTC class
 #endif
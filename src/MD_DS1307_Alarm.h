@@ -0,0 +1,297 @@
+/*
+  MD_DS1307 - Library for using a DS1307 Real Time Clock.
+
+  Created by Marco Colli May 2012
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+ */
+#ifndef MD_DS1307_ALARM_h
+#define MD_DS1307_ALARM_h
+
+#include "MD_DS1307.h"
+
+/**
+ * \file
+ * \brief Software alarms for the MD_DS1307 library
+ */
+
+/**
+ * Alarm identifier returned when an alarm cannot be set.
+ */
+#define DS1307_ALARM_NONE 0xff
+
+/**
+ * Software alarm scheduler object.
+ *
+ * The DS1307 has no alarm hardware, so alarms are kept in software and checked
+ * against the time in the RTC object interface registers. No I2C traffic is
+ * generated - the application reads the time as usual and then calls check().
+ *
+ * Alarms can fire once at a set time, or repeat at an interval, daily at a
+ * time or weekly on a day and time. They are held in a fixed size min-heap
+ * ordered by the next time each is due, so check() only needs to look at the
+ * first alarm when nothing is due, and firing and rescheduling an alarm
+ * takes O(log n) steps.
+ *
+ * If the clock jumps forward the alarms that were passed fire once, and
+ * repeating alarms are rescheduled to their next time after the current time.
+ *
+ * \tparam SIZE maximum number of alarms, up to 254.
+ */
+template <uint8_t SIZE = 8>
+class MD_DS1307Alarm
+{
+  public:
+ /**
+  * Alarm callback function type.
+  *
+  * The function is passed the identifier of the alarm that fired.
+  */
+  typedef void (*alarmCallback_t)(uint8_t id);
+
+ /**
+  * Class Constructor
+  *
+  * \param rtc  the RTC object holding the time. This can be any MD_DS1307T type.
+  */
+  MD_DS1307Alarm(MD_DS1307Base &rtc) : _rtc(rtc), _count(0)
+  {
+    for (uint8_t i = 0; i < SIZE; i++)
+      _pos[i] = NOT_USED;
+  }
+
+ /**
+  * Set a one-shot alarm
+  *
+  * \param t   the packed time when the alarm fires.
+  * \param cb  the function called when the alarm fires.
+  * \return the alarm identifier or DS1307_ALARM_NONE if no alarm could be set.
+  */
+  uint8_t at(ds1307Time_t t, alarmCallback_t cb) { return(add(t, 0, cb)); }
+
+ /**
+  * Set a repeating interval alarm
+  *
+  * The first alarm fires _secs_ seconds after the current time.
+  *
+  * \param secs  the interval in seconds.
+  * \param cb    the function called when the alarm fires.
+  * \return the alarm identifier or DS1307_ALARM_NONE if no alarm could be set.
+  */
+  uint8_t every(uint32_t secs, alarmCallback_t cb)
+  {
+    if (secs == 0) return(DS1307_ALARM_NONE);
+    return(add(_rtc.getTime() + secs, secs, cb));
+  }
+
+ /**
+  * Set a daily alarm
+  *
+  * \param h   hour in 24 hour time [0..23].
+  * \param m   minutes [0..59].
+  * \param cb  the function called when the alarm fires.
+  * \return the alarm identifier or DS1307_ALARM_NONE if no alarm could be set.
+  */
+  uint8_t daily(uint8_t h, uint8_t m, alarmCallback_t cb)
+  {
+    ds1307Time_t now = _rtc.getTime();
+    ds1307Time_t t = now - (now % SECS_DAY) + (h * 3600UL) + (m * 60U);
+
+    if (t <= now) t += SECS_DAY;
+    return(add(t, SECS_DAY, cb));
+  }
+
+ /**
+  * Set a weekly alarm
+  *
+  * \param dow  day of the week [1..7], where 1 = Sunday.
+  * \param h    hour in 24 hour time [0..23].
+  * \param m    minutes [0..59].
+  * \param cb   the function called when the alarm fires.
+  * \return the alarm identifier or DS1307_ALARM_NONE if no alarm could be set.
+  */
+  uint8_t weekly(uint8_t dow, uint8_t h, uint8_t m, alarmCallback_t cb)
+  {
+    ds1307Time_t now = _rtc.getTime();
+    uint16_t days = now / SECS_DAY;
+    uint8_t today = ((days + 6) % 7) + 1;    // 1 Jan 2000 was a Saturday
+    ds1307Time_t t;
+
+    if (dow < 1 || dow > 7) return(DS1307_ALARM_NONE);
+    t = ((uint32_t)(days + ((dow + 7 - today) % 7)) * SECS_DAY) + (h * 3600UL) + (m * 60U);
+    if (t <= now) t += SECS_WEEK;
+    return(add(t, SECS_WEEK, cb));
+  }
+
+ /**
+  * Cancel an alarm
+  *
+  * \param id  the alarm identifier.
+  * \return true if the alarm was cancelled, false if it was not set.
+  */
+  bool cancel(uint8_t id)
+  {
+    if (id >= SIZE || _pos[id] == NOT_USED)
+      return(false);
+
+    remove(_pos[id]);
+    return(true);
+  }
+
+ /**
+  * Check the alarms
+  *
+  * Fire all the alarms that are due at the time in the RTC object interface
+  * registers. One-shot alarms are removed and repeating alarms rescheduled
+  * before their callback is invoked, so a callback can cancel or set alarms.
+  * This should be called after the time is read, for example when readTime()
+  * shows that the seconds changed.
+  *
+  * \return the number of alarms fired.
+  */
+  uint8_t check(void)
+  {
+    ds1307Time_t now = _rtc.getTime();
+    uint8_t fired = 0;
+
+    while (_count != 0 && _alarm[_heap[0]].next <= now)
+    {
+      uint8_t id = _heap[0];
+      alarm_t &a = _alarm[id];
+
+      if (a.period == 0)
+        remove(0);
+      else
+      {
+        a.next += ((now - a.next) / a.period + 1) * a.period;
+        siftDown(0);
+      }
+
+      fired++;
+      if (a.cb != NULL) a.cb(id);
+    }
+
+    return(fired);
+  }
+
+ /**
+  * Get the time of the next alarm
+  *
+  * \param t  receives the packed time the next alarm is due.
+  * \return true if an alarm is set, false otherwise.
+  */
+  bool next(ds1307Time_t &t)
+  {
+    if (_count == 0) return(false);
+    t = _alarm[_heap[0]].next;
+    return(true);
+  }
+
+ /**
+  * Get the number of alarms set
+  *
+  * \return the number of alarms set.
+  */
+  uint8_t getCount(void) { return(_count); }
+
+  private:
+  static const uint32_t SECS_DAY = 86400UL;
+  static const uint32_t SECS_WEEK = 7 * 86400UL;
+  static const uint8_t NOT_USED = 0xff;
+
+  typedef struct
+  {
+    ds1307Time_t next;    // time the alarm is next due
+    uint32_t period;      // seconds between repeats, 0 for one-shot
+    alarmCallback_t cb;   // function called when the alarm fires
+  } alarm_t;
+
+  MD_DS1307Base &_rtc;    // the RTC object holding the time
+  alarm_t _alarm[SIZE];   // alarms, indexed by id
+  uint8_t _heap[SIZE];    // ids in heap order of the next time due
+  uint8_t _pos[SIZE];     // heap position of each id, NOT_USED if free
+  uint8_t _count;         // alarms in the heap
+
+  uint8_t add(ds1307Time_t t, uint32_t period, alarmCallback_t cb)
+  // Set an alarm in a free slot and add it to the heap
+  {
+    uint8_t id;
+
+    if (_count == SIZE) return(DS1307_ALARM_NONE);
+
+    for (id = 0; _pos[id] != NOT_USED; id++)
+      ;   // find a free slot - there must be one
+
+    _alarm[id].next = t;
+    _alarm[id].period = period;
+    _alarm[id].cb = cb;
+    _heap[_count] = id;
+    _pos[id] = _count;
+    siftUp(_count++);
+
+    return(id);
+  }
+
+  void remove(uint8_t i)
+  // Remove the alarm at heap position i
+  {
+    uint8_t last;
+
+    _pos[_heap[i]] = NOT_USED;
+    if (i == --_count)
+      return;
+
+    // fill the gap with the last alarm and move it up or down to its place
+    last = _heap[_count];
+    place(i, last);
+    siftUp(i);
+    siftDown(_pos[last]);
+  }
+
+  void place(uint8_t i, uint8_t id)
+  // Put the alarm id at heap position i
+  {
+    _heap[i] = id;
+    _pos[id] = i;
+  }
+
+  bool earlier(uint8_t i, uint8_t j) { return(_alarm[_heap[i]].next < _alarm[_heap[j]].next); }
+
+  void siftUp(uint8_t i)
+  // Move the alarm at heap position i up to its place
+  {
+    while (i > 0 && earlier(i, (i - 1) / 2))
+    {
+      uint8_t p = (i - 1) / 2;
+      uint8_t id = _heap[i];
+
+      place(i, _heap[p]);
+      place(p, id);
+      i = p;
+    }
+  }
+
+  void siftDown(uint8_t i)
+  // Move the alarm at heap position i down to its place
+  {
+    for (;;)
+    {
+      uint16_t c = (2 * i) + 1;
+      uint8_t id;
+
+      if (c >= _count) break;
+      if (c + 1 < _count && earlier(c + 1, c)) c++;
+      if (!earlier(c, i)) break;
+
+      id = _heap[i];
+      place(i, _heap[c]);
+      place(c, id);
+      i = c;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,268 @@
+/*
+  MD_DS1307 - Library for using a DS1307 Real Time Clock.
+
+  Created by Marco Colli May 2012
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+ */
+#ifndef MD_DS1307_DRIFT_h
+#define MD_DS1307_DRIFT_h
+
+#include "MD_DS1307.h"
+
+/**
+ * \file
+ * \brief Drift calibration for the MD_DS1307 library
+ */
+
+/**
+ * Drift calibration object.
+ *
+ * The DS1307 has no trim register, so crystal drift is corrected in software.
+ * calibrate() compares the RTC with a reference time supplied by the
+ * application (eg, from NTP or GPS) and works out the drift in parts per
+ * million from the error built up since the last calibration, adding back the
+ * corrections made in between. The drift and the times of the last calibration 
+ * and adjustment are kept in a DS1307_DRIFT_SIZE byte record in the battery 
+ * backed RAM, so they survive power loss. The default record address is clear
+ * of the default MD_DS1307Log region.
+ *
+ * update() is called after the time is read. It works out the error built up
+ * since the last adjustment from the interface registers and, only once that
+ * reaches the threshold, corrects the RTC with a single write of the seconds
+ * register, or of the whole time when the correction carries into the 
+ * minutes. Writing the seconds restarts the current second, so each correction
+ * loses up to one second. Half a second is allowed for each time and the rest
+ * is taken up by later corrections; a threshold of a few seconds keeps the 
+ * corrections rare. A correction is limited to 30 seconds, and any error left
+ * over is corrected by the next update().
+ *
+ * The record is
+ *
+ *     [magic][drift (2 bytes)][last adjustment (4 bytes)][last calibration (4 bytes)][check]
+ *
+ * with the drift in 0.01 ppm units (positive when the RTC runs fast) and the
+ * times as packed times, least significant byte first. The last adjustment is
+ * the time from which the drift error not yet corrected has built up.
+ *
+ * \tparam Bus the I2C bus class of the MD_DS1307T object.
+ */
+template <class Bus>
+class MD_DS1307DriftT
+{
+  public:
+ /**
+  * Class Constructor
+  *
+  * \param rtc   the RTC object to correct.
+  * \param addr  RTC address of the calibration record in the battery backed RAM.
+  */
+  MD_DS1307DriftT(MD_DS1307T<Bus> &rtc, uint8_t addr = DS1307_DRIFT_ADDR) :
+    _rtc(rtc), _addr(addr), _valid(false), _drift(0), _last(0), _cal(0), _threshold(2) {}
+
+ /**
+  * Load the calibration
+  *
+  * Read the calibration record from the RTC RAM. This should be called
+  * before the other methods.
+  *
+  * \return true if a valid record was found, false if there is no calibration.
+  */
+  bool begin(void)
+  {
+    uint8_t rec[DS1307_DRIFT_SIZE];
+
+    _valid = false;
+    _drift = 0;
+    if (_rtc.readRAM(_addr, rec, sizeof(rec)) != sizeof(rec) ||
+        rec[0] != DRIFT_MAGIC || rec[DS1307_DRIFT_SIZE - 1] != check(rec))
+      return(false);
+
+    _drift = (int16_t)(rec[1] | (rec[2] << 8));
+    _last = getTime(&rec[3]);
+    _cal = getTime(&rec[7]);
+    _valid = true;
+
+    return(true);
+  }
+
+ /**
+  * Calibrate against a reference time
+  *
+  * Read the RTC and compare it with the reference time. If there was an
+  * earlier calibration, the error built up since then, without the 
+  * corrections made by update(), gives the new drift. The RTC is then set 
+  * to the reference time and the record saved. The longer the time between 
+  * calibrations, the better the drift estimate.
+  *
+  * \param ref  the correct time now, as a packed time.
+  * \return the RTC error in seconds, positive if the RTC was ahead.
+  */
+  int32_t calibrate(ds1307Time_t ref)
+  {
+    ds1307Time_t now;
+    int32_t err;
+
+    _rtc.readTime(now);
+    err = MD_DS1307Base::timeDiff(now, ref);
+
+    // the corrections made since the calibration are the error predicted 
+    // by the drift up to the last adjustment, so add them back to the error 
+    // now to measure the drift over the whole time since the calibration
+    if (_valid && ref > _cal)
+    {
+      float total = err + ((float)(int32_t)(_last - _cal) * _drift / 1e8);
+      float ppm = total * 1e8 / (ref - _cal);
+
+      _drift = (ppm > 32767 ? 32767 : (ppm < -32767 ? -32767 : (int16_t)(ppm + (ppm > 0 ? 0.5 : -0.5))));
+    }
+
+    _rtc.setTime(ref);
+    _rtc.writeTime();
+    _last = _cal = ref;
+    _valid = true;
+    save();
+
+    return(err);
+  }
+
+ /**
+  * Correct the RTC for drift
+  *
+  * Work out the drift error since the last adjustment, using the time in the
+  * interface registers, and correct the seconds register if the error has
+  * reached the threshold. The interface registers are changed to match. This
+  * should be called after the time is read.
+  *
+  * \return true if the RTC was corrected, false otherwise.
+  */
+  bool update(void)
+  {
+    ds1307Time_t now = _rtc.getTime();
+    int8_t delta;
+    float err;
+
+    if (!_valid || _drift == 0 || now <= _last)
+      return(false);
+
+    err = (float)(now - _last) * _drift / 1e8;
+    if (err < _threshold && err > -(float)_threshold)
+      return(false);
+
+    delta = (err > 30 ? -30 : (err < -30 ? 30 : -(int8_t)(err + (err > 0 ? 0.5 : -0.5))));
+    if (_rtc.s + delta >= 0 && _rtc.s + delta <= 59)
+    {
+      _rtc.s += delta;
+      _rtc.writeTime(DS1307_FLD_SEC);
+    }
+    else
+    {
+      // the correction carries into the minutes, so write the whole time
+      _rtc.setTime(now + delta);
+      _rtc.writeTime();
+    }
+
+    // Writing the seconds restarts the current second, losing half a second 
+    // on average. Move the last adjustment on only as far as the error 
+    // corrected, keeping any error left over from the lost fraction, rounding 
+    // or the 30 second limit for the next update().
+    _last = now + delta - (int32_t)((err + delta - 0.5) * 1e8 / _drift);
+    save();
+
+    return(true);
+  }
+
+ /**
+  * Set the correction threshold
+  *
+  * \param secs  the drift error, in seconds, that triggers a correction. The default is 2.
+  */
+  void setThreshold(uint8_t secs) { _threshold = (secs == 0 ? 1 : secs); }
+
+ /**
+  * Get the drift
+  *
+  * \return the drift in 0.01 ppm units, positive if the RTC runs fast.
+  */
+  int16_t getDrift(void) { return(_drift); }
+
+ /**
+  * Set the drift
+  *
+  * Set a known drift, for example from a previous measurement, and save it.
+  * The current time is taken as the last adjustment and calibration.
+  *
+  * \param drift  the drift in 0.01 ppm units, positive if the RTC runs fast.
+  */
+  void setDrift(int16_t drift)
+  {
+    _rtc.readTime(_last);
+    _cal = _last;
+    _drift = drift;
+    _valid = true;
+    save();
+  }
+
+  private:
+  static const uint8_t DRIFT_MAGIC = 0xD2;  // record signature
+
+  MD_DS1307T<Bus> &_rtc;  // the RTC being corrected
+  uint8_t _addr;          // RTC address of the record
+  bool _valid;            // the record is valid
+  int16_t _drift;         // drift in 0.01 ppm, positive if fast
+  ds1307Time_t _last;     // time of the last adjustment
+  ds1307Time_t _cal;      // time of the last calibration
+  uint8_t _threshold;     // error in seconds that triggers a correction
+
+  uint8_t check(const uint8_t* rec)
+  // Checksum of the record data bytes
+  {
+    uint8_t sum = 0;
+
+    for (uint8_t i = 0; i < DS1307_DRIFT_SIZE - 1; i++)
+      sum += rec[i];
+    return(~sum);
+  }
+
+  static ds1307Time_t getTime(const uint8_t* buf)
+  // Unpack a time stored least significant byte first
+  {
+    ds1307Time_t t = 0;
+
+    for (uint8_t i = 4; i > 0; i--)
+      t = (t << 8) | buf[i - 1];
+    return(t);
+  }
+
+  static void putTime(uint8_t* buf, ds1307Time_t t)
+  // Pack a time least significant byte first
+  {
+    for (uint8_t i = 0; i < 4; i++, t >>= 8)
+      buf[i] = t & 0xff;
+  }
+
+  bool save(void)
+  // Write the record to the RTC RAM
+  {
+    uint8_t rec[DS1307_DRIFT_SIZE];
+
+    rec[0] = DRIFT_MAGIC;
+    rec[1] = _drift & 0xff;
+    rec[2] = (_drift >> 8) & 0xff;
+    putTime(&rec[3], _last);
+    putTime(&rec[7], _cal);
+    rec[DS1307_DRIFT_SIZE - 1] = check(rec);
+
+    return(_rtc.writeRAM(_addr, rec, sizeof(rec)) == sizeof(rec));
+  }
+};
+
+/**
+ * The drift calibration for the MD_DS1307 (Wire library) object.
+ */
+typedef MD_DS1307DriftT<TwoWire> MD_DS1307Drift;
+
+#endif
@@ -0,0 +1,286 @@
+/*
+  MD_DS1307 - Library for using a DS1307 Real Time Clock.
+
+  Created by Marco Colli May 2012
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+ */
+#ifndef MD_DS1307_LOG_h
+#define MD_DS1307_LOG_h
+
+#include "MD_DS1307.h"
+
+/**
+ * \file
+ * \brief Event log in the MD_DS1307 battery backed RAM
+ */
+
+/**
+ * Event log object for the battery backed RAM.
+ *
+ * An append-only ring buffer of records held in a region of the RTC battery
+ * backed RAM, so that the most recent events survive power loss. Each record
+ * is a 4 byte timestamp (seconds since 1 Jan 2000, least significant byte
+ * first, as ds1307Time_t) followed by PAYLOAD bytes of user data and a check 
+ * byte. When the log is full the oldest record is overwritten. A record that
+ * fails its check, for example after the RAM lost its battery, is not 
+ * returned.
+ *
+ * The region starts with a 4 byte header
+ *
+ *     [magic][head][count][check]
+ *
+ * where _head_ is the slot for the next record, _count_ the number of records
+ * held and _check_ a checksum of the other header bytes. The region has one 
+ * more slot than the log capacity, so the slot for the next record never holds
+ * a record in the log, even when it is full. An append writes the new record 
+ * and then the header, so a power failure between the two leaves the previous
+ * log intact. A header that fails the checks when the log is started is 
+ * discarded and the log cleared.
+ *
+ * \tparam Bus     the I2C bus class of the MD_DS1307T object.
+ * \tparam PAYLOAD number of user data bytes in each record, 1 or more.
+ */
+template <class Bus, uint8_t PAYLOAD = 4>
+class MD_DS1307LogT
+{
+  public:
+  static const uint8_t RECORD_SIZE = 4 + PAYLOAD + 1; ///< Bytes used by each record in RAM
+  static_assert(PAYLOAD > 0, "DS1307 log records need at least one payload byte");
+
+ /**
+  * Class Constructor
+  *
+  * The log uses _size_ bytes of RAM from RTC address _base_. The default 
+  * region leaves the top of the RAM for the MD_DS1307Drift record. The region 
+  * can be reduced to leave space for other data in the RAM. It needs room for the
+  * header and at least two records, otherwise the log capacity is 0.
+  *
+  * \param rtc   the RTC object that holds the RAM.
+  * \param base  first RTC address of the log region, 8 or more.
+  * \param size  number of bytes in the log region.
+  */
+  MD_DS1307LogT(MD_DS1307T<Bus> &rtc, uint8_t base = DS1307_LOG_ADDR, uint8_t size = DS1307_LOG_SIZE) :
+    _rtc(rtc), _base(base), _slots(0), _cap(0), _head(0), _count(0)
+  {
+    if (base >= 8 && base + size <= DS1307_RAM_MAX && size >= LOG_HEADER + (2 * RECORD_SIZE))
+    {
+      _slots = (size - LOG_HEADER) / RECORD_SIZE;
+      _cap = _slots - 1;    // one slot is always free for the next record
+    }
+  }
+
+ /**
+  * Start the log
+  *
+  * Read the log header from the RTC RAM. If the header is not valid the log
+  * is cleared. This must be called before the log is used.
+  *
+  * \return true if an existing log was found, false if the log was cleared.
+  */
+  bool begin(void)
+  {
+    uint8_t hdr[LOG_HEADER];
+
+    if (_cap != 0 && _rtc.readRAM(_base, hdr, LOG_HEADER) == LOG_HEADER &&
+        hdr[0] == magic() && hdr[3] == check(hdr, 3) && hdr[1] < _slots && hdr[2] <= _cap)
+    {
+      _head = hdr[1];
+      _count = hdr[2];
+      return(true);
+    }
+
+    clear();
+    return(false);
+  }
+
+ /**
+  * Clear the log
+  *
+  * Remove all the records by writing an empty header. The records are not
+  * erased from RAM.
+  */
+  void clear(void)
+  {
+    _head = _count = 0;
+    writeHeader();
+  }
+
+ /**
+  * Append a record
+  *
+  * Add a record stamped with the current RTC time to the log. This reads the
+  * time from the RTC, changing the time fields of the RTC object.
+  *
+  * \param payload  PAYLOAD bytes of user data.
+  * \return true if the record was saved, false otherwise.
+  */
+  bool append(const uint8_t* payload)
+  {
+    ds1307Time_t t;
+
+    _rtc.readTime(t);
+    return(append(t, payload));
+  }
+
+ /**
+  * Append a record with a timestamp
+  *
+  * Add a record with the specified timestamp to the log.
+  *
+  * \param t        timestamp in seconds since 1 Jan 2000.
+  * \param payload  PAYLOAD bytes of user data.
+  * \return true if the record was saved, false otherwise.
+  */
+  bool append(ds1307Time_t t, const uint8_t* payload)
+  {
+    uint8_t rec[RECORD_SIZE];
+
+    if (_cap == 0) return(false);
+
+    for (uint8_t i = 0; i < 4; i++, t >>= 8)
+      rec[i] = t & 0xff;
+    memcpy(&rec[4], payload, PAYLOAD);
+    rec[RECORD_SIZE - 1] = check(rec, RECORD_SIZE - 1);
+
+    if (_rtc.writeRAM(slotAddr(_head), rec, RECORD_SIZE) != RECORD_SIZE)
+      return(false);
+
+    // the record is safe, now make it part of the log
+    _head = (_head + 1) % _slots;
+    if (_count < _cap) _count++;
+    return(writeHeader());
+  }
+
+ /**
+  * Read a record
+  *
+  * Read one record from the RTC RAM. Record 0 is the oldest in the log.
+  *
+  * \param idx      record index, 0 to getCount()-1.
+  * \param t        receives the record timestamp in seconds since 1 Jan 2000.
+  * \param payload  receives PAYLOAD bytes of user data.
+  * \return true if the record was read and passed its check, false otherwise.
+  */
+  bool read(uint8_t idx, ds1307Time_t &t, uint8_t* payload)
+  {
+    uint8_t rec[RECORD_SIZE];
+
+    if (idx >= _count || _rtc.readRAM(slotAddr(slotIndex(idx)), rec, RECORD_SIZE) != RECORD_SIZE)
+      return(false);
+
+    return(unpack(rec, t, payload));
+  }
+
+ /**
+  * Read all the records
+  *
+  * Read the log with one block transfer and invoke the callback for each
+  * record, oldest first. Records that fail their check are skipped. The 
+  * payload pointer passed to the callback is only valid during the callback.
+  *
+  * \param cb  callback function called with the timestamp and payload of each record.
+  * \return the number of records passed to the callback.
+  */
+  uint8_t forEach(void (*cb)(ds1307Time_t t, const uint8_t* payload))
+  {
+    uint8_t buf[DS1307_RAM_MAX - 8];
+    uint8_t len = _slots * RECORD_SIZE;
+    ds1307Time_t t;
+    uint8_t payload[PAYLOAD];
+    uint8_t n = 0;
+
+    if (cb == NULL || _count == 0 || _rtc.readRAM(slotAddr(0), buf, len) != len)
+      return(0);
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+      if (unpack(&buf[slotIndex(i) * RECORD_SIZE], t, payload))
+      {
+        cb(t, payload);
+        n++;
+      }
+    }
+
+    return(n);
+  }
+
+ /**
+  * Get the number of records
+  *
+  * \return the number of records held in the log.
+  */
+  uint8_t getCount(void) { return(_count); }
+
+ /**
+  * Get the log capacity
+  *
+  * \return the maximum number of records the log can hold.
+  */
+  uint8_t getCapacity(void) { return(_cap); }
+
+  private:
+  static const uint8_t LOG_HEADER = 4;  // bytes in the header
+  static const uint8_t LOG_MAGIC = 0xB0;// header signature, combined with the layout
+
+  MD_DS1307T<Bus> &_rtc;  // the RTC holding the RAM
+  uint8_t _base;          // first RTC address of the region
+  uint8_t _slots;         // number of record slots
+  uint8_t _cap;           // maximum records in the log, one less than the slots
+  uint8_t _head;          // slot for the next record
+  uint8_t _count;         // records in the log
+
+  uint8_t magic(void) { return(LOG_MAGIC ^ (_slots << 4) ^ PAYLOAD); }
+  uint8_t check(const uint8_t* buf, uint8_t len)
+  // Return the check byte for len bytes of buf
+  {
+    uint8_t sum = 0;
+
+    for (uint8_t i = 0; i < len; i++)
+      sum += buf[i];
+
+    return(~sum);
+  }
+
+  uint8_t slotAddr(uint8_t slot) { return(_base + LOG_HEADER + (slot * RECORD_SIZE)); }
+  uint8_t slotIndex(uint8_t idx) { return((_head + _slots - _count + idx) % _slots); }
+
+  bool writeHeader(void)
+  // Write the header for the current log state
+  {
+    uint8_t hdr[LOG_HEADER];
+
+    if (_cap == 0) return(false);
+
+    hdr[0] = magic();
+    hdr[1] = _head;
+    hdr[2] = _count;
+    hdr[3] = check(hdr, 3);
+    return(_rtc.writeRAM(_base, hdr, LOG_HEADER) == LOG_HEADER);
+  }
+
+  bool unpack(const uint8_t* rec, ds1307Time_t &t, uint8_t* payload)
+  // Split a record into its timestamp and payload.
+  // Return false if the record fails its check.
+  {
+    if (rec[RECORD_SIZE - 1] != check(rec, RECORD_SIZE - 1))
+      return(false);
+
+    t = 0;
+    for (uint8_t i = 4; i > 0; i--)
+      t = (t << 8) | rec[i - 1];
+    memcpy(payload, &rec[4], PAYLOAD);
+
+    return(true);
+  }
+};
+
+/**
+ * The event log for the MD_DS1307 (Wire library) object, with 4 byte payloads.
+ */
+typedef MD_DS1307LogT<TwoWire> MD_DS1307Log;
+
+#endif
@@ -0,0 +1,221 @@
+/*
+  MD_DS1307 - Library for using a DS1307 Real Time Clock.
+
+  Created by Marco Colli May 2012
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+ */
+#ifndef MD_DS1307_NVRAM_h
+#define MD_DS1307_NVRAM_h
+
+#include "MD_DS1307.h"
+
+/**
+ * \file
+ * \brief Write-back cache for the MD_DS1307 battery backed RAM
+ */
+
+/**
+ * Flush policies.
+ *
+ * These definitions are used with the setPolicy() method to select when
+ * changes in the cache are written to the RTC.
+ */
+#define DS1307_NV_MANUAL    0 ///< Only write changes when flush() is called
+#define DS1307_NV_TIMER     1 ///< Write changes once they are older than the policy parameter (milliseconds)
+#define DS1307_NV_THRESHOLD 2 ///< Write changes once the number of changed bytes reaches the policy parameter
+
+/**
+ * Write-back cache object for the battery backed RAM.
+ *
+ * Keeps a copy of the RTC battery backed RAM (addresses 8 to DS1307_RAM_MAX-1)
+ * in processor memory. Reads are served from the copy and writes only change
+ * the copy, marking the bytes that differ as dirty. flush() writes the dirty
+ * bytes to the RTC, each run of neighbouring dirty bytes in one burst write.
+ * Clean bytes are never written, so RAM written behind the cache (eg, by
+ * MD_DS1307Log or MD_DS1307Drift) is not overwritten, although reads of those
+ * bytes from the cache will be out of date until begin() is called again.
+ *
+ * The flush policy trades durability for bus load. Changes are lost if power
+ * fails before they are flushed.
+ *
+ * \tparam Bus the I2C bus class of the MD_DS1307T object.
+ */
+template <class Bus>
+class MD_DS1307NVRAMT
+{
+  public:
+ /**
+  * Class Constructor
+  *
+  * \param rtc  the RTC object that holds the RAM.
+  */
+  MD_DS1307NVRAMT(MD_DS1307T<Bus> &rtc) : _rtc(rtc), _policy(DS1307_NV_MANUAL),
+    _param(0), _dirtyCount(0), _dirtyTime(0) { memset(_dirty, 0, sizeof(_dirty)); }
+
+ /**
+  * Load the cache
+  *
+  * Read the battery backed RAM from the RTC into the cache, discarding any
+  * changes not yet flushed. This should be called before the cache is used.
+  *
+  * \return true if the RAM was read successfully, false otherwise.
+  */
+  bool begin(void)
+  {
+    memset(_dirty, 0, sizeof(_dirty));
+    _dirtyCount = 0;
+    return(_rtc.readRAM(NV_BASE, _mirror, NV_SIZE) == NV_SIZE);
+  }
+
+ /**
+  * Read from the cache
+  *
+  * Copy _len_ bytes starting at RTC address _addr_ from the cache. No I2C
+  * traffic is generated.
+  *
+  * \param addr  starting RTC address, 8 or more.
+  * \param buf   address of the receiving byte buffer.
+  * \param len   number of bytes to read.
+  * \return number of bytes read.
+  */
+  uint8_t read(uint8_t addr, uint8_t* buf, uint8_t len)
+  {
+    if (!valid(addr, buf, len))
+      return(0);
+
+    memcpy(buf, &_mirror[addr - NV_BASE], len);
+    return(len);
+  }
+
+ /**
+  * Write to the cache
+  *
+  * Copy _len_ bytes to the cache starting at RTC address _addr_, marking the
+  * bytes that change as dirty. The threshold policy may flush the cache.
+  *
+  * \param addr  starting RTC address, 8 or more.
+  * \param buf   address of the data buffer.
+  * \param len   number of bytes to write.
+  * \return number of bytes written.
+  */
+  uint8_t write(uint8_t addr, const uint8_t* buf, uint8_t len)
+  {
+    if (!valid(addr, buf, len))
+      return(0);
+
+    addr -= NV_BASE;
+    for (uint8_t i = 0; i < len; i++, addr++)
+    {
+      if (_mirror[addr] == buf[i])
+        continue;
+
+      _mirror[addr] = buf[i];
+      if (!isDirty(addr))
+      {
+        if (_dirtyCount == 0) _dirtyTime = millis();
+        _dirty[addr >> 3] |= (1 << (addr & 7));
+        _dirtyCount++;
+      }
+    }
+
+    if (_policy == DS1307_NV_THRESHOLD && _dirtyCount >= _param)
+      flush();
+
+    return(len);
+  }
+
+ /**
+  * Set the flush policy
+  *
+  * \param policy  one of the DS1307_NV_* policy values.
+  * \param param   milliseconds for DS1307_NV_TIMER, byte count for DS1307_NV_THRESHOLD.
+  */
+  void setPolicy(uint8_t policy, uint16_t param = 0) { _policy = policy; _param = param; }
+
+ /**
+  * Run the flush policy
+  *
+  * Flush the cache if the timer policy is selected and the oldest change has
+  * reached the time limit. This should be called from the main loop.
+  */
+  void update(void)
+  {
+    if (_policy == DS1307_NV_TIMER && _dirtyCount != 0 && millis() - _dirtyTime >= _param)
+      flush();
+  }
+
+ /**
+  * Write the changes to the RTC
+  *
+  * Write all the dirty bytes to the RTC, each run of neighbouring dirty 
+  * bytes in one burst write.
+  *
+  * \return the number of burst writes used.
+  */
+  uint8_t flush(void)
+  {
+    uint8_t bursts = 0;
+    uint8_t i = 0;
+
+    while (_dirtyCount != 0 && i < NV_SIZE)
+    {
+      uint8_t start, end;
+
+      if (!isDirty(i))
+      {
+        i++;
+        continue;
+      }
+
+      // extend the run over the following dirty bytes
+      start = end = i;
+      for (i++; i < NV_SIZE && isDirty(i); i++)
+        end = i;
+
+      if (_rtc.writeRAM(NV_BASE + start, &_mirror[start], end - start + 1) != end - start + 1)
+        break;    // leave it dirty for the next try
+      bursts++;
+
+      for (uint8_t j = start; j <= end; j++)
+        _dirty[j >> 3] &= ~(1 << (j & 7));
+      _dirtyCount -= end - start + 1;
+    }
+
+    return(bursts);
+  }
+
+ /**
+  * Get the number of dirty bytes
+  *
+  * \return the number of bytes changed in the cache and not yet written to the RTC.
+  */
+  uint8_t getDirtyCount(void) { return(_dirtyCount); }
+
+  private:
+  static const uint8_t NV_BASE = 8;                       // first RAM address
+  static const uint8_t NV_SIZE = DS1307_RAM_MAX - NV_BASE;// number of RAM bytes
+
+  MD_DS1307T<Bus> &_rtc;          // the RTC holding the RAM
+  uint8_t _mirror[NV_SIZE];       // copy of the RAM
+  uint8_t _dirty[(NV_SIZE + 7) / 8];  // one bit per RAM byte changed
+  uint8_t _policy;                // DS1307_NV_* flush policy
+  uint16_t _param;                // flush policy parameter
+  uint8_t _dirtyCount;            // number of dirty bytes
+  uint32_t _dirtyTime;            // millis() when the oldest change was made
+
+  bool isDirty(uint8_t i) { return(_dirty[i >> 3] & (1 << (i & 7))); }
+
+  bool valid(uint8_t addr, const uint8_t* buf, uint8_t len)
+  { return(buf != NULL && len != 0 && addr >= NV_BASE && addr + len <= DS1307_RAM_MAX); }
+};
+
+/**
+ * The battery backed RAM cache for the MD_DS1307 (Wire library) object.
+ */
+typedef MD_DS1307NVRAMT<TwoWire> MD_DS1307NVRAM;
+
+#endif
@@ -0,0 +1,18 @@
+/*
+  MD_DS1307 - Library for using a DS1307 Real Time Clock.
+  
+  Created by Marco Colli May 2012
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+ */
+#include "MD_DS1307.h"
+
+// The library is linked as an archive (dot_a_linkage in library.properties), 
+// so this file is only linked, and the object only takes RAM, in sketches 
+// that use RTC.
+#ifndef ARDUINO_ARCH_SAMD
+MD_DS1307 RTC;  // one instance created when library is included
+#endif
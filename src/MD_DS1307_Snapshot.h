@@ -0,0 +1,128 @@
+/*
+  MD_DS1307 - Library for using a DS1307 Real Time Clock.
+
+  Created by Marco Colli May 2012
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+ */
+#ifndef MD_DS1307_SNAPSHOT_h
+#define MD_DS1307_SNAPSHOT_h
+
+#include "MD_DS1307.h"
+
+/**
+ * \file
+ * \brief Interrupt safe time snapshot for the MD_DS1307 library
+ */
+
+/**
+ * Time snapshot object.
+ *
+ * Interrupt handlers should not read the RTC object interface registers
+ * directly, as readTime() updates them one at a time and an interrupt can see
+ * a mix of old and new values. The main loop calls publish() after readTime()
+ * and the interrupt handler reads a consistent copy with get().
+ *
+ * Two copies are kept. The new time is written to the copy not in use and
+ * then made current by a single byte sequence count update, so an interrupt
+ * handler never sees a partly written copy and interrupts are never disabled.
+ */
+class MD_DS1307Snapshot
+{
+  public:
+ /**
+  * Time snapshot record.
+  *
+  * A copy of the interface registers taken by publish(), for reading with
+  * get().
+  */
+  struct snapshot_t
+  {
+    uint16_t yyyy;  ///< Year including the century
+    uint8_t mm;     ///< Month (1-12)
+    uint8_t dd;     ///< Date of the month (1-31)
+    uint8_t h;      ///< Hour of the day, as the h interface register
+    uint8_t m;      ///< Minutes past the hour (0-59)
+    uint8_t s;      ///< Seconds past the minute (0-59)
+    uint8_t dow;    ///< Day of the week (1-7)
+    uint8_t pm;     ///< Non-zero if 12 hour clock mode and PM
+  };
+
+ /**
+  * Class Constructor
+  *
+  * \param rtc  the RTC object holding the time. This can be any MD_DS1307T type.
+  */
+  MD_DS1307Snapshot(MD_DS1307Base &rtc) : _rtc(rtc), _seq(0) {}
+
+ /**
+  * Publish the time for interrupt handlers
+  *
+  * Copy the RTC object interface registers into the snapshot read by get().
+  * Call this from the main loop after readTime().
+  */
+  void publish(void)
+  {
+    uint8_t seq = _seq + 1;
+    snapshot_t *p;
+
+    if (seq == 0) seq = 2;    // 0 is kept for 'never published', 2 keeps the copies alternating
+    p = &_snap[seq & 1];
+
+    p->yyyy = _rtc.yyyy;
+    p->mm = _rtc.mm;
+    p->dd = _rtc.dd;
+    p->h = _rtc.h;
+    p->m = _rtc.m;
+    p->s = _rtc.s;
+    p->dow = _rtc.dow;
+    p->pm = _rtc.pm;
+
+    barrier();
+    _seq = seq;
+  }
+
+ /**
+  * Get the published time
+  *
+  * Copy the time last published by publish(). This is safe to call from an
+  * interrupt handler and takes a few microseconds. If the copy is published
+  * again while it is being read, which can only happen when the reader runs
+  * on another core, the read is repeated.
+  *
+  * \param snap  receives the published time.
+  * \return true if a time has been published, false otherwise.
+  */
+  bool get(snapshot_t &snap)
+  {
+    uint8_t seq;
+
+    do
+    {
+      seq = _seq;
+      barrier();
+      snap = _snap[seq & 1];
+      barrier();
+    } while (seq != _seq);
+
+    return(seq != 0);
+  }
+
+  private:
+  MD_DS1307Base &_rtc;        // the RTC object holding the time
+  snapshot_t _snap[2];        // published copies, the current one is _seq & 1
+  volatile uint8_t _seq;      // sequence count, 0 until the first publish()
+
+  // Memory barrier for the sequence count. AVR is single core, so only the
+  // compiler needs to be stopped from reordering the accesses.
+#ifdef __AVR__
+  static void barrier(void) { __asm__ __volatile__("" ::: "memory"); }
+#else
+  static void barrier(void) { __sync_synchronize(); }
+#endif
+};
+
+#endif
@@ -0,0 +1,272 @@
+/*
+  MD_DS1307 - Library for using a DS1307 Real Time Clock.
+
+  Created by Marco Colli May 2012
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+ */
+#ifndef MD_DS1307_TZ_h
+#define MD_DS1307_TZ_h
+
+#include "MD_DS1307.h"
+
+/**
+ * \file
+ * \brief Time zone and daylight saving for the MD_DS1307 library
+ */
+
+/**
+ * Time zone object.
+ *
+ * The RTC is kept in UTC and converted to local time using a POSIX TZ style
+ * rule, for example
+ *
+ *     "AEST-10AEDT,M10.1.0,M4.1.0/3"
+ *     "CET-1CEST,M3.5.0,M10.5.0/3"
+ *     "EST5EDT,M3.2.0,M11.1.0"
+ *
+ * The rule has the standard time name and offset (hours west of UTC, so
+ * positive in the Americas), optionally followed by the daylight saving name,
+ * offset (one hour ahead of standard time if omitted) and the start and end
+ * rules as Mm.w.d[/time]. This is day d (0 = Sunday) of week w (1 to 4, or
+ * 5 for the last) in month m. The time is the local time of the change and
+ * defaults to 02:00. Names may be letters or quoted in angle brackets, such
+ * as <+0530>. Julian day rules (Jn and n) are not supported.
+ *
+ * The two transitions for a year are worked out once, as packed UTC times,
+ * and kept until a time in another year is converted. Converting a time is
+ * then a range check, one or two compares and an add. No I2C traffic is
+ * generated - the application reads the time as usual and then calls now().
+ */
+class MD_DS1307TZ
+{
+  public:
+ /**
+  * Class Constructor
+  *
+  * The time zone is UTC until setRule() is called.
+  *
+  * \param rtc  the RTC object holding the UTC time. This can be any MD_DS1307T type.
+  */
+  MD_DS1307TZ(MD_DS1307Base &rtc) : _rtc(rtc), _stdOff(0), _dstOff(0), _hasDST(false),
+    _yearStart(1), _yearEnd(0) {}
+
+ /**
+  * Set the time zone rule
+  *
+  * \param tz  the POSIX TZ style rule.
+  * \return true if the rule was set, false if it is not valid. The time zone is unchanged if invalid.
+  */
+  bool setRule(const char *tz)
+  {
+    int32_t stdOff, dstOff;
+    rule_t start, end;
+    bool hasDST = false;
+
+    if (!getName(tz) || !getOffset(tz, stdOff))
+      return(false);
+    stdOff = -stdOff;       // POSIX offsets are west of UTC
+    dstOff = stdOff + 3600;
+
+    if (*tz != '\0')
+    {
+      if (!getName(tz))
+        return(false);
+      if (*tz != ',' && *tz != '\0')
+      {
+        if (!getOffset(tz, dstOff))
+          return(false);
+        dstOff = -dstOff;
+      }
+      if (!getRule(tz, start) || !getRule(tz, end) || *tz != '\0')
+        return(false);
+      hasDST = true;
+    }
+
+    _stdOff = stdOff;
+    _dstOff = dstOff;
+    _hasDST = hasDST;
+    _start = start;
+    _end = end;
+    _yearStart = 1;   // empty range, so the cache is rebuilt
+    _yearEnd = 0;
+
+    return(true);
+  }
+
+ /**
+  * Get the local time
+  *
+  * Convert the time in the RTC object interface registers to local time.
+  * This should be called after the time is read.
+  *
+  * \return the local time as a packed time.
+  */
+  ds1307Time_t now(void) { return(toLocal(_rtc.getTime())); }
+
+ /**
+  * Convert UTC to local time
+  *
+  * \param t  the UTC packed time.
+  * \return the local packed time.
+  */
+  ds1307Time_t toLocal(ds1307Time_t t) { return(t + offset(t)); }
+
+ /**
+  * Convert local time to UTC
+  *
+  * A local time that occurs twice, in the hour repeated at the end of
+  * daylight saving, is taken as the earlier of the two. A local time skipped
+  * at the start of daylight saving is taken as standard time.
+  *
+  * \param t  the local packed time.
+  * \return the UTC packed time.
+  */
+  ds1307Time_t toUTC(ds1307Time_t t)
+  {
+    if (_hasDST && isDST(t - _dstOff))
+      return(t - _dstOff);
+
+    return(t - _stdOff);
+  }
+
+ /**
+  * Get the offset from UTC
+  *
+  * \param t  the UTC packed time.
+  * \return the seconds to add to UTC to give local time at time t.
+  */
+  int32_t offset(ds1307Time_t t) { return(_hasDST && isDST(t) ? _dstOff : _stdOff); }
+
+ /**
+  * Check for daylight saving
+  *
+  * \param t  the UTC packed time.
+  * \return true if daylight saving is in force at time t, false otherwise.
+  */
+  bool isDST(ds1307Time_t t)
+  {
+    if (!_hasDST)
+      return(false);
+
+    if (t < _yearStart || t >= _yearEnd)
+      setYear(t);
+
+    // daylight saving spans the new year in the southern hemisphere
+    if (_dstStart < _dstEnd)
+      return(t >= _dstStart && t < _dstEnd);
+    return(t >= _dstStart || t < _dstEnd);
+  }
+
+  private:
+  typedef struct
+  {
+    uint8_t mm;     // month [1..12]
+    uint8_t week;   // week of the month [1..5], 5 is the last
+    uint8_t day;    // day of the week [0..6], 0 = Sunday
+    int32_t secs;   // local time of the change in seconds after midnight
+  } rule_t;
+
+  MD_DS1307Base &_rtc;    // the RTC object holding the UTC time
+  int32_t _stdOff;        // standard time offset east of UTC in seconds
+  int32_t _dstOff;        // daylight saving offset east of UTC in seconds
+  bool _hasDST;           // the time zone has daylight saving
+  rule_t _start, _end;    // daylight saving start and end rules
+
+  // Transition cache for one year
+  ds1307Time_t _yearStart;  // UTC start of the cached year
+  ds1307Time_t _yearEnd;    // UTC start of the next year
+  ds1307Time_t _dstStart;   // UTC time daylight saving starts in the year
+  ds1307Time_t _dstEnd;     // UTC time daylight saving ends in the year
+
+  void setYear(ds1307Time_t t)
+  // Work out the transitions for the year holding time t
+  {
+    uint16_t yyyy;
+    uint8_t mm, dd;
+
+    MD_DS1307Base::civilFromDays(t / 86400UL, yyyy, mm, dd);
+    _yearStart = MD_DS1307Base::makeTime(yyyy, 1, 1);
+    _yearEnd = MD_DS1307Base::makeTime(yyyy + 1, 1, 1);
+    _dstStart = transition(yyyy, _start) - _stdOff;   // start rule is in standard time
+    _dstEnd = transition(yyyy, _end) - _dstOff;       // end rule is in daylight saving time
+  }
+
+  static ds1307Time_t transition(uint16_t yyyy, const rule_t &r)
+  // Return the local packed time of the rule in the year
+  {
+    uint16_t first = MD_DS1307Base::daysFromCivil(yyyy, r.mm, 1);
+    uint16_t next = (r.mm == 12 ? MD_DS1307Base::daysFromCivil(yyyy + 1, 1, 1) : MD_DS1307Base::daysFromCivil(yyyy, r.mm + 1, 1));
+    uint16_t day = first + ((r.day + 7 - ((first + 6) % 7)) % 7) + (7 * (r.week - 1));   // 1 Jan 2000 was a Saturday
+
+    if (day >= next) day -= 7;    // there is no 5th week, use the last
+
+    return((day * 86400UL) + r.secs);
+  }
+
+  static bool getName(const char *&p)
+  // Skip a time zone name, either 3 or more letters or quoted in <>
+  {
+    uint8_t n = 0;
+
+    if (*p == '<')
+    {
+      while (*++p != '>')
+        if (*p == '\0') return(false);
+      p++;
+      return(true);
+    }
+
+    for (; isalpha(*p); p++)
+      n++;
+
+    return(n >= 3);
+  }
+
+  static bool getNum(const char *&p, uint8_t maxVal, uint8_t &v)
+  // Read 1 or 2 decimal digits, up to maxVal
+  {
+    if (!isdigit(*p)) return(false);
+    v = *p++ - '0';
+    if (isdigit(*p)) v = (v * 10) + (*p++ - '0');
+
+    return(v <= maxVal);
+  }
+
+  static bool getOffset(const char *&p, int32_t &secs)
+  // Read a signed [+-]hh[:mm[:ss]] offset or time of day in seconds
+  {
+    bool neg = (*p == '-');
+    uint8_t hr, mi = 0, se = 0;
+
+    if (*p == '-' || *p == '+') p++;
+    if (!getNum(p, 167, hr)) return(false);
+    if (*p == ':' && !getNum(++p, 59, mi)) return(false);
+    if (*p == ':' && !getNum(++p, 59, se)) return(false);
+
+    secs = (hr * 3600L) + (mi * 60) + se;
+    if (neg) secs = -secs;
+
+    return(true);
+  }
+
+  static bool getRule(const char *&p, rule_t &r)
+  // Read a ,Mm.w.d[/time] rule
+  {
+    if (*p++ != ',' || *p++ != 'M') return(false);
+    if (!getNum(p, 12, r.mm) || r.mm == 0 || *p++ != '.') return(false);
+    if (!getNum(p, 5, r.week) || r.week == 0 || *p++ != '.') return(false);
+    if (!getNum(p, 6, r.day)) return(false);
+
+    r.secs = 7200;    // default 02:00
+    if (*p == '/')
+      return(getOffset(++p, r.secs));
+
+    return(true);
+  }
+};
+
+#endif
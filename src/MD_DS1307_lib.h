@@ -0,0 +1,1159 @@
+/*
+  MD_DS1307 - Library for using a DS1307 Real Time Clock.
+  
+  Created by Marco Colli May 2012
+  
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public
+  License as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+ */
+#ifndef MD_DS1307_LIB_h
+#define MD_DS1307_LIB_h
+
+/**
+ * \file
+ * \brief Private definitions and template implementation for the MD_DS1307 library
+ *
+ * This file is included by MD_DS1307.h and should not be included directly.
+ */
+
+// Register map and asynchronous state constants, for any odr-use
+#if DS1307_CONTROL_BATCH
+template <class Bus> constexpr uint8_t MD_DS1307T<Bus>::BATCH_SLOTS;
+#endif
+#if DS1307_ASYNC
+template <class Bus> constexpr uint8_t MD_DS1307T<Bus>::ASYNC_IDLE;
+template <class Bus> constexpr uint8_t MD_DS1307T<Bus>::ASYNC_LOCAL;
+template <class Bus> constexpr uint8_t MD_DS1307T<Bus>::ASYNC_MODE;
+template <class Bus> constexpr uint8_t MD_DS1307T<Bus>::ASYNC_POINTER;
+template <class Bus> constexpr uint8_t MD_DS1307T<Bus>::ASYNC_READ;
+template <class Bus> constexpr uint8_t MD_DS1307T<Bus>::ASYNC_WRITE;
+template <class Bus> constexpr uint8_t MD_DS1307T<Bus>::ASYNC_CHUNK;
+#endif
+
+// Bus statistics accounting
+#if DS1307_BUS_STATS
+#define I2C_BIT_TIME  10    // microseconds per bit at 100kHz
+#define STATS_OP(op)  statScope _statScope(*this, (op))
+#define STATS_BUS(t, b) countBus((t), (b))
+#define STATS_ERR(f)  _stats[_statOp].f++
+#else
+#define STATS_OP(op)
+#define STATS_BUS(t, b)
+#define STATS_ERR(f)  ((void)0)
+#endif
+
+#if DS1307_SQW_TICK
+// Object serviced by the SQW interrupt handler, one per bus type
+template <class Bus>
+MD_DS1307T<Bus> *MD_DS1307T<Bus>::_sqwInstance = NULL;
+#endif
+
+// Interface functions for the RTC device
+template <class Bus>
+bool MD_DS1307T<Bus>::setPointer(uint8_t addr)
+// Set the device register pointer for the next read
+{
+  _bus.beginTransmission(DS1307_ID);
+  _bus.write(addr);       // set register address                  
+  STATS_BUS(1, 2);        // device address + register address
+  if (_bus.endTransmission() != 0)
+  {
+    STATS_ERR(nacks);
+    return(false);
+  }
+
+  return(true);
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::readBlock(uint8_t* buf, uint8_t len)
+// Read len bytes from the current register pointer, len <= DS1307_BUS_BUFFER.
+// Return the number of bytes actually received.
+{
+  uint8_t n = _bus.requestFrom(DS1307_ID, (int)len);
+
+  STATS_BUS(1, len + 1);  // device address + data
+  if (n == 0)
+    STATS_ERR(nacks);
+  else if (n < len)
+    STATS_ERR(shortReads);
+  if (n > len) n = len;
+  for (uint8_t i=0; i<n; i++)   // Read x data from given address upwards...
+  {
+    buf[i] = _bus.read();       // ... and store it in the buffer
+  }
+
+  return(n);
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::readDevice(uint8_t addr, uint8_t* buf, uint8_t len)
+// Read len bytes starting at addr. The register pointer is set once and 
+// the data is read in bus buffer sized chunks, back to back, as the device
+// moves the pointer on after each byte.
+// Return the number of bytes actually read.
+{
+  uint8_t count = 0;
+
+  if (!setPointer(addr))
+    return(0);
+
+  while (count < len)
+  {
+    uint8_t n = len - count;
+    uint8_t got;
+
+    if (n > DS1307_BUS_BUFFER) n = DS1307_BUS_BUFFER;
+    got = readBlock(&buf[count], n);
+    count += got;
+    if (got != n)   // short read, give up here
+      break;
+  }
+
+  return(count);
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::writeDevice(uint8_t addr, uint8_t* buf, uint8_t len)
+// Write len bytes starting at addr, in chunks that fit the bus buffer 
+// together with the register address.
+// Return the number of bytes acknowledged by the device.
+{
+  uint8_t count = 0;
+
+  while (count < len)
+  {
+    uint8_t n = len - count;
+
+    if (n > DS1307_BUS_BUFFER - 1) n = DS1307_BUS_BUFFER - 1;
+
+    _bus.beginTransmission(DS1307_ID);
+    _bus.write(addr + count);     // set register address                  
+    for (uint8_t i=0; i<n; i++)   // Send x data from given address upwards...
+    {
+      _bus.write(buf[count + i]); // ... and send it from buffer
+    }
+    STATS_BUS(1, n + 2);          // device address + register address + data
+    if (_bus.endTransmission() != 0)
+    {
+      STATS_ERR(nacks);
+      break;
+    }
+    count += n;
+  }
+
+  return(count);
+}
+
+#if DS1307_BUS_STATS
+template <class Bus>
+void MD_DS1307T<Bus>::countBus(uint8_t trans, uint8_t bytes)
+// Accumulate the bus usage against the current operation
+{
+  busStats_t *p = &_stats[_statOp];
+
+  p->trans += trans;
+  p->bytes += bytes;
+  // 9 bits per byte (data + ACK), plus START and STOP for each transaction
+  p->busTime += ((9 * (uint32_t)bytes) + (2 * trans)) * I2C_BIT_TIME;
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::statStart(uint8_t op)
+// Count a call to the operation and account the bus usage against it.
+// Return the operation accounted before.
+{
+  uint8_t prev = _statOp;
+
+  _statOp = op;
+  _stats[op].calls++;
+
+  return(prev);
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::statTime(uint32_t t)
+// Count the time taken by a call to the current operation in its histogram bucket
+{
+  uint8_t b = 0;
+
+  for (t /= DS1307_STATS_BUCKET_US; t != 0 && b < DS1307_STATS_BUCKETS - 1; t >>= 1)
+    b++;
+  _stats[_statOp].latency[b]++;
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::getBusStats(uint8_t op, busStats_t &stats)
+{
+  if (op >= DS1307_OP_COUNT)
+    return(false);
+
+  stats = _stats[op];
+  return(true);
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::resetBusStats(void)
+{
+  memset(_stats, 0, sizeof(_stats));
+}
+#endif
+
+template <class Bus>
+void MD_DS1307T<Bus>::updateShadow(uint8_t addr, uint8_t v)
+// Keep the cached copies in line with a register value read or written
+{
+  switch (addr)
+  {
+    case ADDR_CTL_CH:   
+      _shadowFlags = (_shadowFlags & ~CTL_CH) | (v & CTL_CH);
+      _shadowKnown |= CTL_CH;
+      break;
+
+    case ADDR_CTL_12H:
+      _shadowFlags = (_shadowFlags & ~CTL_12H) | (v & CTL_12H);
+      _shadowKnown |= CTL_12H;
+      break;
+
+    case ADDR_CTL_SQWE: _shadowCtl = v; break;
+  }
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::init()
+{
+  _cacheOn = _cacheValid = false;
+  _shadowCtl = _shadowFlags = _shadowKnown = 0;
+#if DS1307_CONTROL_BATCH
+  _batchOn = false;
+#endif
+#if DS1307_SOFT_CLOCK
+  _softOn = _softValid = false;
+  _softMillis = 0;
+  _softResync = 0;
+#endif
+#if DS1307_SQW_TICK
+  _tickIntr = -1;
+  _tickFlag = false;
+  _tickCallback = NULL;
+  _sqwEdges = 0;
+  _sqwShift = 0;
+#endif
+#if DS1307_ASYNC
+  _asyncState = ASYNC_IDLE;
+  _asyncOp = DS1307_OP_READ_TIME;
+  _asyncCount = 0;
+  _asyncCallback = NULL;
+#endif
+#if DS1307_BUS_STATS
+  resetBusStats();
+  _statOp = DS1307_OP_READ_TIME;
+  _cacheHits = _cacheMisses = 0;
+#endif
+}
+
+// Bus start functions. The pin version is a separate function so that it 
+// is only compiled for bus types that have begin(sda, scl).
+template <class Bus>
+void MD_DS1307T<Bus>::busDefault(Bus &bus, int sda, int scl)
+{
+  (void)sda;
+  (void)scl;
+  bus.begin();
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::busPins(Bus &bus, int sda, int scl)
+{
+  bus.begin(sda, scl);
+}
+
+// Class functions
+template <class Bus>
+MD_DS1307T<Bus>::MD_DS1307T(Bus &bus) : _bus(bus)
+{
+  init();
+  _sda = _scl = -1;
+  _busStart = busDefault;
+}
+
+template <class Bus>
+MD_DS1307T<Bus>::MD_DS1307T(int sda, int scl, Bus &bus) : _bus(bus)
+{
+  init();
+  _sda = sda;
+  _scl = scl;
+  _busStart = busPins;
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::begin(uint8_t *hdr, uint8_t len, const uint8_t *sig, uint8_t sigLen)
+// Read the time, control register and RAM header in one transfer and 
+// report what was found in them
+{
+  uint8_t frame[DS1307_RAM_MAX];
+  uint8_t flags = DS1307_BOOT_OK;
+
+  STATS_OP(DS1307_OP_BEGIN);
+  _busStart(_bus, _sda, _scl);
+
+  if (len > DS1307_RAM_MAX - RAM_BASE_WRITE) len = DS1307_RAM_MAX - RAM_BASE_WRITE;
+  if (sigLen > len) sigLen = len;
+
+  if (readDevice(RAM_BASE_READ, frame, RAM_BASE_WRITE + len) != RAM_BASE_WRITE + len)
+  {
+    _cacheValid = false;
+    return(DS1307_BOOT_NO_RTC);
+  }
+
+  // the frame holds all the cached registers, so it also loads the cache
+  updateShadow(ADDR_CTL_SQWE, frame[ADDR_CTL_SQWE]);
+  _cacheValid = true;
+
+  if (frame[ADDR_CTL_CH] & CTL_CH)
+    flags |= DS1307_BOOT_HALTED;
+  if (!frameValid(frame))
+    flags |= DS1307_BOOT_BAD_TIME;
+  if (sig != NULL && memcmp(&frame[RAM_BASE_WRITE], sig, sigLen) != 0)
+    flags |= DS1307_BOOT_BAD_SIG;
+
+  // a halted clock or missing signature still has a usable time
+  acceptTime(frame, !(flags & DS1307_BOOT_BAD_TIME));
+
+  if (hdr != NULL)
+    memcpy(hdr, &frame[RAM_BASE_WRITE], len);
+
+  return(flags);
+}
+ 
+#if DS1307_SOFT_CLOCK
+template <class Bus>
+void MD_DS1307T<Bus>::softClock(bool b, uint32_t resync)
+{
+  _softOn = b;
+  _softValid = false;
+  _softResync = resync * 1000UL;
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::softCurrent(void)
+// Return true if the soft clock anchor can be used for the time
+{
+  return(_softOn && _softValid && (millis() - _softMillis < _softResync));
+}
+#endif
+
+#if DS1307_SQW_TICK
+template <class Bus>
+void MD_DS1307T<Bus>::sqwISR(void)
+// Count the SQW edges for the object in tick mode
+{
+  _sqwInstance->_sqwEdges++;
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::tickBegin(uint8_t pin)
+{
+  return(sqwBegin(pin, DS1307_SQW_1HZ));
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::fineBegin(uint8_t pin, uint8_t freq)
+{
+  if (freq != DS1307_SQW_4KHZ && freq != DS1307_SQW_8KHZ && freq != DS1307_SQW_32KHZ)
+    return(false);
+
+  return(sqwBegin(pin, freq));
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::sqwBegin(uint8_t pin, uint8_t freq)
+// Set up the SQW output and the interrupt handler to count the edges
+{
+  int intr = digitalPinToInterrupt(pin);
+
+  if (intr < 0)
+    return(false);
+
+  tickEnd();
+  if (_sqwInstance != NULL)   // another object owns the interrupt
+    _sqwInstance->tickEnd();
+
+  switch (freq)   // log2 of the number of edges per second
+  {
+    case DS1307_SQW_4KHZ:  _sqwShift = 12; break;
+    case DS1307_SQW_8KHZ:  _sqwShift = 13; break;
+    case DS1307_SQW_32KHZ: _sqwShift = 15; break;
+    default:               _sqwShift = 0;  break;
+  }
+
+  control(DS1307_SQW_TYPE_ON, freq);
+  control(DS1307_SQW_RUN, DS1307_ON);
+
+  pinMode(pin, INPUT_PULLUP);
+  _sqwInstance = this;
+  _tickIntr = intr;
+  attachInterrupt(intr, sqwISR, FALLING);
+
+  if (!tickSync())
+  {
+    tickEnd();
+    return(false);
+  }
+  _tickFlag = false;
+
+  return(true);
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::tickSync(void)
+// Anchor the edge count to the RTC time.
+// Return false if the RTC could not be read, leaving the anchor unchanged.
+{
+  if (_sqwShift == 0)
+  {
+    // Each edge is a new second. If an edge arrives while reading,
+    // the time may be from either side of it, so read again.
+    do
+    {
+      noInterrupts();
+      _sqwEdges = 0;
+      interrupts();
+      if (!readClock())
+        return(false);
+    } while (_sqwEdges != 0);
+  }
+  else
+  {
+    // Zero the count as close as possible to the start of an RTC second, 
+    // found by polling the seconds register for a change. The resolution
+    // is one poll, so the bus is polled back to back for up to a second.
+    uint8_t sec, start;
+    uint32_t timeStart = millis();
+
+    if (readDevice(ADDR_SEC, &start, 1) != 1)
+      return(false);
+    if (!(start & CTL_CH))    // halted clock will never change
+    {
+      do
+      {
+        if (readDevice(ADDR_SEC, &sec, 1) != 1)
+          return(false);
+      } while (sec == start && millis() - timeStart < 1100);
+    }
+
+    noInterrupts();
+    _sqwEdges = 0;
+    interrupts();
+    if (!readClock())
+      return(false);
+  }
+
+  memcpy(_anchor, _buf, sizeof(_anchor));
+
+  return(true);
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::tickEnd(void)
+{
+  if (_tickIntr < 0)
+    return;
+
+  detachInterrupt(_tickIntr);
+  _tickIntr = -1;
+  _sqwInstance = NULL;
+}
+
+template <class Bus>
+uint16_t MD_DS1307T<Bus>::applyTicks(void)
+// Move the anchor on by the whole seconds counted in the interrupt handler 
+// and unpack it into the interface registers. The fraction of the current
+// second is returned in units of 1/65536 second.
+{
+  uint32_t n, rem;
+  bool mode12 = _anchor[ADDR_HR] & CTL_12H;
+
+  // take the whole seconds, leaving the fraction counting
+  noInterrupts();
+  n = _sqwEdges >> _sqwShift;
+  _sqwEdges -= (n << _sqwShift);
+  rem = _sqwEdges;
+  interrupts();
+
+  unpackTime(_anchor);
+  if (n != 0)
+  {
+    advance(n, mode12);
+    packTime(_anchor, mode12);
+    _tickFlag = true;
+  }
+
+  if (_sqwShift == 0)
+    return(0);
+
+  // the remaining count is less than one second, so it fits in 16 bits
+  return((uint16_t)(rem << (16 - _sqwShift)));
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::readTimeFine(uint16_t &frac)
+{
+  STATS_OP(DS1307_OP_READ_TIME);
+
+  if (_tickIntr < 0 || _sqwShift == 0)
+  {
+    updateTime();
+    frac = 0;
+    return;
+  }
+
+  frac = applyTicks();
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::tickCheck(void)
+{
+  bool b;
+
+  if (_tickIntr < 0)
+    return(false);
+
+  applyTicks();
+  b = _tickFlag;
+  _tickFlag = false;
+
+  if (b && _tickCallback != NULL)
+    _tickCallback();
+
+  return(b);
+}
+#endif
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::readTime(void)
+{
+  STATS_OP(DS1307_OP_READ_TIME);
+
+  return(updateTime());
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::updateTime(void)
+// Update the object variables from the tick count, the soft clock or a read 
+// of the RTC. Return the fields that changed.
+{
+  uint8_t prev[8];
+
+  saveFields(prev);
+
+#if DS1307_SQW_TICK
+  if (_tickIntr >= 0)
+  {
+    applyTicks();
+    return(changedFields(prev));
+  }
+#endif
+#if DS1307_SOFT_CLOCK
+  if (softCurrent())
+  {
+    // extrapolate from the anchor, unless the clock is halted
+    unpackTime(_anchor);
+    if (!(_anchor[ADDR_SEC] & CTL_CH))
+      advance((millis() - _softMillis) / 1000, _anchor[ADDR_HR] & CTL_12H);
+    return(changedFields(prev));
+  }
+#endif
+  readClock();
+
+  return(changedFields(prev));
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::readClock(void)
+// Read the time registers from the RTC into the object variables.
+// Return true if the time was read.
+{
+  bool b;
+
+  b = (readDevice(RAM_BASE_READ, _buf, 7) == 7);
+  acceptTime(_buf, b);
+
+  return(b);
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::acceptTime(const uint8_t *buf, bool valid)
+// Unpack time registers read from the RTC and keep the anchor and 
+// shadow registers in step with them
+{
+#if DS1307_SOFT_CLOCK
+  // a time that is not valid leaves the next read to the RTC
+  _softValid = (valid && _softOn);
+  if (_softValid)
+  {
+    memcpy(_anchor, buf, sizeof(_anchor));
+    _softMillis = millis();
+  }
+#else
+  (void)valid;
+#endif
+
+  unpackTime(buf);
+
+  // the time frame carries the CH and 12H bits for free
+  updateShadow(ADDR_CTL_CH, buf[ADDR_SEC]);
+  updateShadow(ADDR_CTL_12H, buf[ADDR_HR]);
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::writeTime(uint8_t fields)
+// Pack up and write the time stored in the object variables to the RTC.
+// Only the contiguous range of registers covering the fields is written.
+// Note: Setting the seconds will also start the clock if it is halted
+{
+  uint8_t lo, hi;
+
+  STATS_OP(DS1307_OP_WRITE_TIME);
+
+  if (!fieldRange(fields, lo, hi))
+    return;
+
+  // pack it up in the current space and send the range needed
+  packTime(_buf, hourMode());
+  writeDevice(lo, &_buf[lo], hi - lo + 1);
+  timeWritten(_buf, lo, hi);
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::hourMode(void)
+// Return true if the RTC is in 12 hour mode, only asking the RTC if we don't know
+{
+  if (!(_shadowKnown & CTL_12H))
+  {
+    uint8_t v;
+
+    if (readDevice(ADDR_HR, &v, 1) == 1)
+      updateShadow(ADDR_CTL_12H, v);
+  }
+
+  return(_shadowFlags & CTL_12H);
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::setTime(ds1307Time_t t)
+// Set the object variables from a packed time
+{
+  unpackSeconds(t, hourMode());
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::timeWritten(const uint8_t *buf, uint8_t lo, uint8_t hi)
+// Keep the anchor and shadow registers in step with the time registers 
+// lo to hi written from buf
+{
+  // writing the seconds restarts the RTC second, so anchor here
+  if (lo == ADDR_SEC && hi == ADDR_YR)
+  {
+#if DS1307_SQW_TICK
+    if (_tickIntr >= 0)
+    {
+      noInterrupts();
+      _sqwEdges = 0;
+      interrupts();
+      memcpy(_anchor, buf, sizeof(_anchor));
+    }
+#endif
+#if DS1307_SOFT_CLOCK
+    if (_softOn)
+    {
+      memcpy(_anchor, buf, sizeof(_anchor));
+      _softMillis = millis();
+      _softValid = true;
+    }
+#endif
+  }
+  else
+    anchorLost();
+
+  if (lo == ADDR_SEC) updateShadow(ADDR_CTL_CH, buf[ADDR_SEC]);
+  if (lo <= ADDR_HR && hi >= ADDR_HR) updateShadow(ADDR_CTL_12H, buf[ADDR_HR]);
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::anchorLost(void)
+// The time registers changed without a full time write, so the soft clock 
+// and tick mode anchors no longer match the RTC
+{
+#if DS1307_SOFT_CLOCK
+  _softValid = false;
+#endif
+#if DS1307_SQW_TICK
+  if (_tickIntr >= 0)
+    tickSync();
+#endif
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::readRAM(uint8_t addr, uint8_t* buf, uint8_t len)
+// Read len bytes from the RTC, starting at address addr, and put them in buf
+// Reading includes all bytes at addresses RAM_BASE_READ to DS1307_RAM_MAX-1
+{
+  STATS_OP(DS1307_OP_READ_RAM);
+  if ((NULL == buf) || (len == 0) || (addr + len > DS1307_RAM_MAX))
+    return(0);
+
+  return(readDevice(addr, buf, len));
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::writeRAM(uint8_t addr, uint8_t* buf, uint8_t len)
+// Write len bytes from buffer buf to the RTC, starting at address addr
+// Writing addresses excludes the RTC registers, so valid addresses are 
+// RAM_BASE_WRITE to DS1307_RAM_MAX-1
+{
+  STATS_OP(DS1307_OP_WRITE_RAM);
+  if ((NULL == buf) || (addr < RAM_BASE_WRITE) || 
+      (len == 0) || (addr + len > DS1307_RAM_MAX))
+    return(0);
+
+  return(writeDevice(addr, buf, len));
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::dumpRAM(uint8_t* buf)
+// Read the whole register file into buf
+{
+  return(readRAM(RAM_BASE_READ, buf, DS1307_RAM_MAX));
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::restoreRAM(uint8_t* buf)
+// Write the battery backed RAM part of a register file image in buf
+{
+  return(writeRAM(RAM_BASE_WRITE, &buf[RAM_BASE_WRITE], DS1307_RAM_MAX - RAM_BASE_WRITE));
+}
+
+#if DS1307_ASYNC
+template <class Bus>
+bool MD_DS1307T<Bus>::asyncStart(uint8_t op, uint8_t state, uint8_t addr, uint8_t* buf, uint8_t len, uint8_t chunk)
+// Set up the asynchronous operation for poll() to run
+{
+  if (_asyncState != ASYNC_IDLE)
+    return(false);
+
+#if DS1307_BUS_STATS
+  _statOp = statStart(op);    // count the call now, poll() accounts the bus
+  _asyncMicros = micros();
+#endif
+  _asyncOp = op;
+  _asyncState = state;
+  _asyncAddr = addr;
+  _asyncBuf = buf;
+  _asyncLen = len;
+  _asyncChunk = chunk;
+  _asyncCount = 0;
+
+  return(true);
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::beginReadTime(void)
+{
+  bool local = false;
+
+#if DS1307_SQW_TICK
+  local = (_tickIntr >= 0);
+#endif
+#if DS1307_SOFT_CLOCK
+  local = local || softCurrent();
+#endif
+
+  // time that needs no RTC read completes on the next poll()
+  return(asyncStart(DS1307_OP_READ_TIME, local ? ASYNC_LOCAL : ASYNC_POINTER, 
+                    RAM_BASE_READ, _asyncFrame, sizeof(_asyncFrame), sizeof(_asyncFrame)));
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::beginWriteTime(uint8_t fields)
+{
+  uint8_t lo, hi;
+
+  if (!fieldRange(fields, lo, hi))
+    return(false);
+
+  // the time frame is packed when it is sent, once the hour mode is known
+  return(asyncStart(DS1307_OP_WRITE_TIME, (_shadowKnown & CTL_12H) ? ASYNC_WRITE : ASYNC_MODE, 
+                    lo, &_asyncFrame[lo], hi - lo + 1, hi - lo + 1));
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::beginReadRAM(uint8_t addr, uint8_t* buf, uint8_t len)
+{
+  if ((NULL == buf) || (len == 0) || (addr + len > DS1307_RAM_MAX))
+    return(false);
+
+  return(asyncStart(DS1307_OP_READ_RAM, ASYNC_POINTER, addr, buf, len, ASYNC_CHUNK));
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::beginWriteRAM(uint8_t addr, uint8_t* buf, uint8_t len)
+{
+  if ((NULL == buf) || (addr < RAM_BASE_WRITE) || 
+      (len == 0) || (addr + len > DS1307_RAM_MAX))
+    return(false);
+
+  return(asyncStart(DS1307_OP_WRITE_RAM, ASYNC_WRITE, addr, buf, len, ASYNC_CHUNK));
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::poll(void)
+// Run the next step of the asynchronous operation, accounting its bus use
+// to the operation. Return true when the operation completes.
+{
+#if DS1307_BUS_STATS
+  uint8_t prev = _statOp;
+  bool b;
+
+  _statOp = _asyncOp;
+  b = pollStep();
+  _statOp = prev;
+
+  return(b);
+#else
+  return(pollStep());
+#endif
+}
+
+template <class Bus>
+bool MD_DS1307T<Bus>::pollStep(void)
+// Run the next step of the asynchronous operation. Each step is at most 
+// one short I2C transaction. Return true when the operation completes.
+{
+  uint8_t state = _asyncState;
+  uint8_t n = _asyncLen - _asyncCount;
+
+  if (n > _asyncChunk) n = _asyncChunk;
+
+  switch (_asyncState)
+  {
+    case ASYNC_IDLE:
+      return(false);
+
+    case ASYNC_LOCAL:   // soft clock or tick mode time
+      updateTime();
+      _asyncCount = _asyncLen;
+      break;
+
+    case ASYNC_MODE:    // find the hour mode before packing the time
+      {
+        uint8_t v;
+
+        if (readDevice(ADDR_HR, &v, 1) != 1)
+          break;
+        updateShadow(ADDR_CTL_12H, v);
+        _asyncState = ASYNC_WRITE;
+      }
+      return(false);
+
+    case ASYNC_POINTER:
+      if (!setPointer(_asyncAddr))
+        break;
+      _asyncState = ASYNC_READ;
+      return(false);
+
+    case ASYNC_READ:    // the register pointer moves on with each read
+      if (readBlock(&_asyncBuf[_asyncCount], n) != n)
+        break;
+      _asyncCount += n;
+      if (_asyncCount < _asyncLen)
+        return(false);
+      break;
+
+    case ASYNC_WRITE:
+      if (_asyncOp == DS1307_OP_WRITE_TIME)
+        packTime(_asyncFrame, _shadowFlags & CTL_12H);
+      if (writeDevice(_asyncAddr + _asyncCount, &_asyncBuf[_asyncCount], n) != n)
+        break;
+      _asyncCount += n;
+      if (_asyncCount < _asyncLen)
+        return(false);
+      break;
+  }
+
+  // operation completed or failed, finish it off
+  _asyncState = ASYNC_IDLE;
+#if DS1307_BUS_STATS
+  statTime(micros() - _asyncMicros);
+#endif
+  if (_asyncCount == _asyncLen)
+  {
+    if (state == ASYNC_READ && _asyncOp == DS1307_OP_READ_TIME)
+      acceptTime(_asyncFrame, true);
+    else if (_asyncOp == DS1307_OP_WRITE_TIME)
+      timeWritten(_asyncFrame, _asyncAddr, _asyncAddr + _asyncLen - 1);
+  }
+
+  if (_asyncCallback != NULL)
+    _asyncCallback(_asyncOp, _asyncCount);
+
+  return(true);
+}
+#endif
+
+// Control item decoding. These are constexpr so that the control<>() and 
+// status<>() templates resolve to constants, and are shared with the run 
+// time control() and status().
+template <class Bus>
+constexpr bool MD_DS1307T<Bus>::ctlValid(uint8_t item, uint8_t value)
+// Return true if value is valid for the control item
+{
+  return(item == DS1307_SQW_TYPE_ON ? (value >= DS1307_SQW_1HZ && value <= DS1307_SQW_32KHZ) :
+         item == DS1307_SQW_TYPE_OFF ? (value == DS1307_SQW_LOW || value == DS1307_SQW_HIGH) :
+         item <= DS1307_12H ? (value == DS1307_ON || value == DS1307_OFF) : false);
+}
+
+template <class Bus>
+constexpr uint8_t MD_DS1307T<Bus>::ctlAddr(uint8_t item)
+// Return the register address holding the control item
+{
+  return(item == DS1307_CLOCK_HALT ? ADDR_CTL_CH : item == DS1307_12H ? ADDR_CTL_12H : ADDR_CTL_SQWE);
+}
+
+template <class Bus>
+constexpr uint8_t MD_DS1307T<Bus>::ctlBits(uint8_t item)
+// Return the register bits used by the control item
+{
+  return(item == DS1307_CLOCK_HALT ? CTL_CH : item == DS1307_SQW_RUN ? CTL_SQWE :
+         item == DS1307_SQW_TYPE_ON ? CTL_RS : item == DS1307_SQW_TYPE_OFF ? CTL_OUT : CTL_12H);
+}
+
+template <class Bus>
+constexpr uint8_t MD_DS1307T<Bus>::ctlCmd(uint8_t item, uint8_t value)
+// Return the register bits to set for a valid item and value.
+// The DS1307_SQW_* frequencies are in the same order as the RS bit values.
+{
+  return(item == DS1307_SQW_TYPE_ON ? value - DS1307_SQW_1HZ :
+         (value == DS1307_ON || value == DS1307_SQW_HIGH) ? ctlBits(item) : 0);
+}
+
+template <class Bus>
+constexpr uint8_t MD_DS1307T<Bus>::statusDecode(uint8_t item, uint8_t v)
+// Return the status value for a valid item from its register value v
+{
+  return(item == DS1307_SQW_TYPE_ON ? DS1307_SQW_1HZ + (v & CTL_RS) :
+         item == DS1307_SQW_TYPE_OFF ? (v & CTL_OUT ? DS1307_SQW_HIGH : DS1307_SQW_LOW) :
+         (v & ctlBits(item) ? DS1307_ON : DS1307_OFF));
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::controlWrite(uint8_t addr, uint8_t mask, uint8_t cmd, uint8_t mode12)
+// Read-modify-write the register at addr. mode12 is the DS1307_12H value 
+// when the hour mode is being changed, 0 otherwise.
+{
+  // now read the address from the RTC, unless the cache already has it
+  if (_cacheOn && _cacheValid && addr == ADDR_CTL_SQWE)
+    _buf[0] = _shadowCtl;
+  else
+    readDevice(addr, _buf, 1);
+
+  // do any special processing here
+  if (mode12 != 0)   // changing 12/24H clock - special handling of hours conversion
+    _buf[0] = convertHour(_buf[0], mode12 == DS1307_ON);
+
+  // Mask off the new status, set the value and then write it back
+  _buf[0] &= mask;
+  _buf[0] |= cmd;
+  writeDevice(addr, _buf, 1);
+  updateShadow(addr, _buf[0]);
+  if (addr != ADDR_CTL_SQWE)  // clock halt or hour mode changed the time registers
+    anchorLost();
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::control(uint8_t item, uint8_t value)
+// Perform a control action on item, using the value
+{
+  STATS_OP(DS1307_OP_CONTROL);
+
+  if (!ctlValid(item, value))
+    return;   // parameters were wrong - make no fuss and just go back
+
+  controlSet(item, value, ctlAddr(item), (uint8_t)~ctlBits(item), ctlCmd(item, value));
+}
+
+template <class Bus>
+template <uint8_t item, uint8_t value>
+void MD_DS1307T<Bus>::control(void)
+// Perform a control action on item, using the value, decoded by the compiler
+{
+  static_assert(ctlValid(item, value), "invalid DS1307 control item and value");
+
+  STATS_OP(DS1307_OP_CONTROL);
+  controlSet(item, value, ctlAddr(item), (uint8_t)~ctlBits(item), ctlCmd(item, value));
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::controlSet(uint8_t item, uint8_t value, uint8_t addr, uint8_t mask, uint8_t cmd)
+// Write the decoded control action, or queue it if batching.
+// mask is used to clear the bits being set (ANDed) and cmd sets the new bit values (ORed).
+{
+#if DS1307_CONTROL_BATCH
+  if (_batchOn)   // queue it up for commitControl()
+  {
+    uint8_t i = batchIndex(addr);
+
+    _batchMask[i] &= mask;
+    _batchCmd[i] = (_batchCmd[i] & mask) | cmd;
+    if (item == DS1307_12H) _batch12H = value;
+    return;
+  }
+#endif
+
+  controlWrite(addr, mask, cmd, item == DS1307_12H ? value : 0);
+}
+
+#if DS1307_CONTROL_BATCH
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::batchIndex(uint8_t addr)
+// Map the control register address to the batch slot
+{
+  switch (addr)
+  {
+    case ADDR_CTL_CH:  return(0);
+    case ADDR_CTL_12H: return(1);
+    default:           return(2);  // ADDR_CTL_SQWE, ADDR_CTL_RS, ADDR_CTL_OUT
+  }
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::beginControl(void)
+{
+  for (uint8_t i = 0; i < BATCH_SLOTS; i++)
+  {
+    _batchMask[i] = 0xff;
+    _batchCmd[i] = 0;
+  }
+  _batch12H = 0;
+  _batchOn = true;
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::commitControl(void)
+{
+  static const uint8_t addr[BATCH_SLOTS] = { ADDR_CTL_CH, ADDR_CTL_12H, ADDR_CTL_SQWE };
+
+  if (!_batchOn)
+    return;
+
+  STATS_OP(DS1307_OP_CONTROL);
+  _batchOn = false;
+  for (uint8_t i = 0; i < BATCH_SLOTS; i++)
+  {
+    if (_batchMask[i] != 0xff)   // something queued for this register
+      controlWrite(addr[i], _batchMask[i], _batchCmd[i], addr[i] == ADDR_CTL_12H ? _batch12H : 0);
+  }
+}
+#endif
+
+template <class Bus>
+void MD_DS1307T<Bus>::refresh(void)
+{
+  STATS_OP(DS1307_OP_STATUS);
+  loadShadow();
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::loadShadow(void)
+// Load the shadow registers from the device
+{
+  if (readDevice(RAM_BASE_READ, _buf, 8) != 8)
+  {
+    _cacheValid = false;
+    return;
+  }
+
+  updateShadow(ADDR_CTL_CH, _buf[ADDR_CTL_CH]);
+  updateShadow(ADDR_CTL_12H, _buf[ADDR_CTL_12H]);
+  updateShadow(ADDR_CTL_SQWE, _buf[ADDR_CTL_SQWE]);
+  _cacheValid = true;
+}
+
+template <class Bus>
+void MD_DS1307T<Bus>::cacheCheck(void)
+// Load the shadow registers if they are not valid, counting the hit or miss
+{
+#if DS1307_BUS_STATS
+  if (_cacheValid)
+    _cacheHits++;
+  else
+    _cacheMisses++;
+#endif
+
+  if (!_cacheValid)
+    loadShadow();
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::status(uint8_t item)
+// Obtain the status of the controllable item and return it.
+// Return DS1307_ERROR otherwise.
+{
+  STATS_OP(DS1307_OP_STATUS);
+
+  if (_cacheOn)
+  {
+    cacheCheck();
+
+    // rebuild the registers of interest from the shadow copies
+    _buf[ADDR_CTL_CH] = _shadowFlags & CTL_CH;
+    _buf[ADDR_CTL_12H] = _shadowFlags & CTL_12H;
+    _buf[ADDR_CTL_SQWE] = _shadowCtl;
+  }
+  else
+    readDevice(RAM_BASE_READ, _buf, 8);   // read all the data once
+
+  if (item <= DS1307_12H)
+    return(statusDecode(item, _buf[ctlAddr(item)]));
+
+  return(DS1307_ERROR); // parameters were wrong - make no fuss and just go back
+}
+
+template <class Bus>
+template <uint8_t item>
+uint8_t MD_DS1307T<Bus>::status(void)
+// Obtain the status of the controllable item, decoded by the compiler
+{
+  static_assert(item <= DS1307_12H, "invalid DS1307 status item");
+
+  STATS_OP(DS1307_OP_STATUS);
+  return(statusDecode(item, readControl(ctlAddr(item))));
+}
+
+template <class Bus>
+uint8_t MD_DS1307T<Bus>::readControl(uint8_t addr)
+// Return the register at addr holding control bits, from the cache if 
+// enabled, otherwise reading just that register
+{
+  uint8_t v = 0;
+
+  if (_cacheOn)
+  {
+    cacheCheck();
+    return(addr == ADDR_CTL_SQWE ? _shadowCtl : _shadowFlags);
+  }
+
+  readDevice(addr, &v, 1);
+  updateShadow(addr, v);
+  return(v);
+}
+
+// The accounting macros are private to this file
+#undef I2C_BIT_TIME
+#undef STATS_OP
+#undef STATS_BUS
+#undef STATS_ERR
+
+#endif
@@ -0,0 +1,213 @@
+/*
+  Simulated DS1307 for the MD_DS1307 host tests.
+ */
+#include "DS1307Sim.h"
+
+static uint8_t bcd2bin(uint8_t v) { return(v - 6 * (v >> 4)); }
+static uint8_t bin2bcd(uint8_t v) { return(v + 6 * (v / 10)); }
+
+static uint8_t daysInMonth(uint8_t mon, uint8_t yr)
+{
+  static const uint8_t dim[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+  return(mon == 2 && yr % 4 == 0 ? 29 : dim[mon - 1]);  // device leap year rule
+}
+
+DS1307Sim::DS1307Sim(void) : _intr(-1)
+{
+  powerUp();
+  resetCounts();
+  hostAddDevice(elapseHook, this);
+}
+
+DS1307Sim::~DS1307Sim(void)
+{
+  hostRemoveDevice(this);
+}
+
+void DS1307Sim::powerUp(void)
+{
+  memset(reg, 0, sizeof(reg));
+  reg[0] = 0x80;    // CH set
+  reg[3] = 0x01;
+  reg[4] = 0x01;
+  reg[5] = 0x01;
+  reg[7] = 0x03;    // OUT and SQWE clear, RS = 32kHz
+  ptr = 0;
+  nack = false;
+  shortRead = -1;
+  failAfter = -1;
+  drift = 0;
+  _driftAcc = 0;
+  _subMicros = 0;
+  _level = false;
+}
+
+void DS1307Sim::account(uint8_t bytes)
+{
+  counts.trans++;
+  counts.bytes += bytes;
+  counts.busTime += ((9 * (uint32_t)bytes) + 2) * SIM_BIT_TIME;
+  hostAdvance(((9 * (uint32_t)bytes) + 2) * SIM_BIT_TIME);
+}
+
+bool DS1307Sim::answer(void)
+// Return true if the device acknowledges its address
+{
+  if (failAfter == 0)
+    nack = true;
+  else if (failAfter > 0)
+    failAfter--;
+
+  return(!nack);
+}
+
+bool DS1307Sim::write(const uint8_t *buf, uint8_t len)
+{
+  if (!answer())
+  {
+    account(1);
+    return(false);
+  }
+
+  if (len > 0)
+  {
+    ptr = buf[0] % SIM_REGS;
+    for (uint8_t i = 1; i < len; i++)
+    {
+      if (ptr == 0) _subMicros = 0;   // writing the seconds resets the divider
+      reg[ptr] = buf[i];
+      ptr = (ptr + 1) % SIM_REGS;
+    }
+  }
+  account(len + 1);
+
+  return(true);
+}
+
+uint8_t DS1307Sim::read(uint8_t *buf, uint8_t len)
+{
+  if (!answer())
+  {
+    account(1);
+    return(0);
+  }
+
+  if (shortRead >= 0 && len > shortRead)
+    len = shortRead;
+  for (uint8_t i = 0; i < len; i++)
+  {
+    buf[i] = reg[ptr];
+    ptr = (ptr + 1) % SIM_REGS;
+  }
+  account(len + 1);
+
+  return(len);
+}
+
+void DS1307Sim::tick(void)
+{
+  uint8_t hr = reg[2];
+  bool mode12 = hr & 0x40;
+  uint8_t h = bcd2bin(hr & (mode12 ? 0x1f : 0x3f));
+  bool pm = mode12 && (hr & 0x20);
+  bool newDay = false;
+
+  if (bcd2bin(reg[0] & 0x7f) < 59) { reg[0] = bin2bcd(bcd2bin(reg[0]) + 1); return; }
+  reg[0] = 0;
+  if (bcd2bin(reg[1]) < 59) { reg[1] = bin2bcd(bcd2bin(reg[1]) + 1); return; }
+  reg[1] = 0;
+
+  if (mode12)
+  {
+    if (h == 11)
+    {
+      newDay = pm;
+      pm = !pm;
+      h = 12;
+    }
+    else
+      h = (h == 12 ? 1 : h + 1);
+    reg[2] = 0x40 | (pm ? 0x20 : 0) | bin2bcd(h);
+  }
+  else
+  {
+    newDay = (h == 23);
+    reg[2] = bin2bcd(newDay ? 0 : h + 1);
+  }
+
+  if (!newDay)
+    return;
+
+  reg[3] = (reg[3] % 7) + 1;
+  if (bcd2bin(reg[4]) < daysInMonth(bcd2bin(reg[5]), bcd2bin(reg[6])))
+  {
+    reg[4] = bin2bcd(bcd2bin(reg[4]) + 1);
+    return;
+  }
+  reg[4] = 1;
+  if (bcd2bin(reg[5]) < 12) { reg[5] = bin2bcd(bcd2bin(reg[5]) + 1); return; }
+  reg[5] = 1;
+  reg[6] = bin2bcd((bcd2bin(reg[6]) + 1) % 100);
+}
+
+uint32_t DS1307Sim::sqwEdges(void)
+// Square wave half periods in a second, 0 if the output is static
+{
+  static const uint32_t hz[] = { 1, 4096, 8192, 32768 };
+
+  if (!(reg[7] & 0x10))
+    return(0);
+
+  return(2 * hz[reg[7] & 0x03]);
+}
+
+void DS1307Sim::elapse(uint32_t us)
+{
+  uint32_t edges = sqwEdges();
+
+  if (edges == 0)
+    _level = reg[7] & 0x80;
+
+  if (reg[0] & 0x80)    // halted oscillator, nothing moves
+    return;
+
+  if (drift != 0)       // oscillator time runs fast or slow
+  {
+    int64_t extra;
+
+    _driftAcc += (int64_t)us * drift;
+    extra = _driftAcc / 100000000LL;
+    _driftAcc -= extra * 100000000LL;
+    us = (uint32_t)((int64_t)us + extra);
+  }
+
+  // The square wave is locked to the oscillator, with a falling edge at 
+  // the start of each second. Step from one half period to the next.
+  while (us > 0)
+  {
+    uint32_t n = (edges == 0 ? 0 : (uint32_t)(((uint64_t)_subMicros * edges) / 1000000UL));
+    uint32_t next = (edges == 0 ? 1000000UL : (uint32_t)(((uint64_t)(n + 1) * 1000000UL + edges - 1) / edges));
+    uint32_t step = next - _subMicros;
+
+    if (us < step)
+    {
+      _subMicros += us;
+      break;
+    }
+
+    us -= step;
+    _subMicros = next;
+    if (_subMicros >= 1000000UL) 
+    { 
+      _subMicros = 0;
+      tick();
+    }
+    if (edges != 0)
+    {
+      _level = ((((uint64_t)_subMicros * edges) / 1000000UL) % 2) != 0;
+      if (!_level)
+        hostInterrupt(_intr);
+    }
+  }
+}
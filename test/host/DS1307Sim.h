@@ -0,0 +1,68 @@
+/*
+  Simulated DS1307 for the MD_DS1307 host tests.
+
+  The 64 byte register file, register pointer wrap, the oscillator with the
+  CH, 12H and PM bits and the SQW/OUT pin are modelled from the data sheet.
+  The oscillator runs as host time is advanced, and each I2C transaction 
+  advances host time by its duration at 100kHz.
+ */
+#ifndef DS1307SIM_h
+#define DS1307SIM_h
+
+#include <Arduino.h>
+
+#define SIM_ID        0x68  // I2C device address
+#define SIM_REGS      64    // registers + NVRAM
+#define SIM_BIT_TIME  10    // microseconds per bit at 100kHz
+
+class DS1307Sim
+{
+  public:
+  // Bus usage, counted in the same way as the library bus statistics
+  struct counts_t
+  {
+    uint32_t trans;     // I2C transactions
+    uint32_t bytes;     // bytes on the bus, including the device address
+    uint32_t busTime;   // microseconds on the bus
+  };
+
+  uint8_t reg[SIM_REGS];  // register file
+  uint8_t ptr;            // register pointer
+  counts_t counts;        // bus usage since resetCounts()
+
+  // Fault injection
+  bool nack;              // do not acknowledge the device address
+  int8_t shortRead;       // if >= 0, return at most this many bytes per read
+  int16_t failAfter;      // if >= 0, transactions answered before acting as nack
+
+  int32_t drift;          // oscillator error in 0.01 ppm, positive runs fast
+
+  DS1307Sim(void);
+  ~DS1307Sim(void);
+
+  void powerUp(void);     // data sheet power on state, oscillator halted
+  void resetCounts(void) { memset(&counts, 0, sizeof(counts)); }
+  void attachSQW(int intr) { _intr = intr; }  // deliver SQW falling edges to this interrupt
+  bool sqwLevel(void) { return(_level); }
+
+  // I2C slave side, called by the TwoWire stub
+  bool write(const uint8_t *buf, uint8_t len);      // address byte then data
+  uint8_t read(uint8_t *buf, uint8_t len);
+
+  // Oscillator
+  void elapse(uint32_t us);
+  void tick(void);        // one second
+
+  private:
+  uint32_t _subMicros;    // microseconds into the current second
+  int64_t _driftAcc;      // oscillator error not yet applied, in 1e-8 us
+  bool _level;            // SQW/OUT pin level
+  int _intr;              // interrupt for SQW falling edges
+
+  void account(uint8_t bytes);
+  bool answer(void);
+  uint32_t sqwEdges(void);
+  static void elapseHook(void *ctx, uint32_t us) { ((DS1307Sim *)ctx)->elapse(us); }
+};
+
+#endif
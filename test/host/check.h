@@ -0,0 +1,20 @@
+/*
+  Minimal check helpers for the MD_DS1307 host tests.
+
+  Each test program counts the failed checks and returns the count from
+  main(), so ctest sees a non-zero exit code on failure.
+ */
+#ifndef CHECK_h
+#define CHECK_h
+
+#include <stdio.h>
+
+static unsigned checkFails = 0;
+
+#define CHECK(c) do { if (!(c)) { checkFails++; printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); } } while (0)
+#define CHECK_EQ(a, b) do { long long _a = (long long)(a), _b = (long long)(b); \
+  if (_a != _b) { checkFails++; printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); } } while (0)
+
+#define CHECK_RESULT() (printf("%s: %u failed\n", checkFails ? "FAIL" : "PASS", checkFails), checkFails == 0 ? 0 : 1)
+
+#endif
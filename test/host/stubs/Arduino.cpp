@@ -0,0 +1,71 @@
+/*
+  Host build stand-in for the Arduino core - time and interrupts.
+ */
+#include "Arduino.h"
+
+#define MAX_INTR    2
+#define MAX_DEVICE  4
+
+static uint64_t hostMicros = 0;
+static void (*isrTable[MAX_INTR])(void);
+
+static struct
+{
+  void (*elapse)(void *ctx, uint32_t us);
+  void *ctx;
+} devTable[MAX_DEVICE];
+
+int digitalPinToInterrupt(uint8_t pin) { return(pin == 2 || pin == 3 ? pin - 2 : NOT_AN_INTERRUPT); }
+
+void pinMode(uint8_t pin, uint8_t mode) { (void)pin; (void)mode; }
+
+void attachInterrupt(int intr, void (*isr)(void), int mode)
+{
+  (void)mode;
+  if (intr >= 0 && intr < MAX_INTR)
+    isrTable[intr] = isr;
+}
+
+void detachInterrupt(int intr)
+{
+  if (intr >= 0 && intr < MAX_INTR)
+    isrTable[intr] = NULL;
+}
+
+void hostInterrupt(int intr)
+{
+  if (intr >= 0 && intr < MAX_INTR && isrTable[intr] != NULL)
+    isrTable[intr]();
+}
+
+uint32_t millis(void) { return((uint32_t)(hostMicros / 1000)); }
+uint32_t micros(void) { return((uint32_t)hostMicros); }
+uint64_t hostMicros64(void) { return(hostMicros); }
+void delay(uint32_t ms) { hostAdvance(ms * 1000UL); }
+void delayMicroseconds(uint32_t us) { hostAdvance(us); }
+
+void hostAdvance(uint32_t us)
+{
+  hostMicros += us;
+  for (uint8_t i = 0; i < MAX_DEVICE; i++)
+    if (devTable[i].elapse != NULL)
+      devTable[i].elapse(devTable[i].ctx, us);
+}
+
+void hostAddDevice(void (*elapse)(void *ctx, uint32_t us), void *ctx)
+{
+  for (uint8_t i = 0; i < MAX_DEVICE; i++)
+    if (devTable[i].elapse == NULL)
+    {
+      devTable[i].elapse = elapse;
+      devTable[i].ctx = ctx;
+      return;
+    }
+}
+
+void hostRemoveDevice(void *ctx)
+{
+  for (uint8_t i = 0; i < MAX_DEVICE; i++)
+    if (devTable[i].ctx == ctx)
+      devTable[i].elapse = NULL;
+}
@@ -0,0 +1,66 @@
+/*
+  Host build stand-in for the parts of the Arduino core used by the MD_DS1307
+  library and its host tests.
+
+  Time only moves when hostAdvance() is called, either by a test or by the 
+  simulated I2C bus for the time each transaction takes on the wire.
+ */
+#ifndef ARDUINO_HOST_h
+#define ARDUINO_HOST_h
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define F_CPU 16000000UL
+
+// Program memory is ordinary memory on the host
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p)  (*(const uint8_t *)(p))
+#define pgm_read_word(p)  (*(const uint16_t *)(p))
+#define strncmp_P   strncmp
+#define strlen_P    strlen
+#define memcpy_P    memcpy
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+// Pins and interrupts
+#define LOW     0
+#define HIGH    1
+#define INPUT   0
+#define OUTPUT  1
+#define INPUT_PULLUP  2
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+#define NOT_AN_INTERRUPT  -1
+
+int digitalPinToInterrupt(uint8_t pin);   // pins 2 and 3 are interrupts 0 and 1, as on an Uno
+void pinMode(uint8_t pin, uint8_t mode);
+void attachInterrupt(int intr, void (*isr)(void), int mode);
+void detachInterrupt(int intr);
+inline void noInterrupts(void) {}
+inline void interrupts(void) {}
+
+// Time
+uint32_t millis(void);
+uint32_t micros(void);
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+// Host control of the simulated world
+void hostAdvance(uint32_t us);          // move time on, running the simulated devices
+uint64_t hostMicros64(void);            // host time in microseconds, without wrap
+void hostInterrupt(int intr);           // run the handler attached to an interrupt
+void hostAddDevice(void (*elapse)(void *ctx, uint32_t us), void *ctx);  // called by hostAdvance()
+void hostRemoveDevice(void *ctx);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+  Host build stand-in for the Arduino Wire library.
+ */
+#include <Wire.h>
+#include "DS1307Sim.h"
+
+DS1307Sim WireDevice;
+TwoWire Wire(WireDevice);
+
+size_t TwoWire::write(uint8_t v)
+{
+  if (_txLen >= BUFFER_LENGTH)
+    return(0);
+
+  _txBuf[_txLen++] = v;
+  return(1);
+}
+
+uint8_t TwoWire::endTransmission(bool stop)
+// Return 0 on success, 2 for a NACK on the address, as the AVR library
+{
+  (void)stop;
+  if (_addr != SIM_ID || !_dev.write(_txBuf, _txLen))
+    return(2);
+
+  return(0);
+}
+
+uint8_t TwoWire::requestFrom(uint8_t addr, int len)
+{
+  _rxLen = _rxPos = 0;
+  if (len > BUFFER_LENGTH) len = BUFFER_LENGTH;
+  if (addr != SIM_ID || len <= 0)
+    return(0);
+
+  _rxLen = _dev.read(_rxBuf, len);
+  return(_rxLen);
+}
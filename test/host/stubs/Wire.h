@@ -0,0 +1,50 @@
+/*
+  Host build stand-in for the Arduino Wire library.
+
+  Each TwoWire object is a bus with one simulated DS1307 on it. Transactions
+  are buffered as in the AVR library, with the same BUFFER_LENGTH limit, and
+  passed to the device by endTransmission() and requestFrom().
+ */
+#ifndef WIRE_HOST_h
+#define WIRE_HOST_h
+
+#include <Arduino.h>
+
+#define BUFFER_LENGTH 32
+
+class DS1307Sim;
+
+class TwoWire
+{
+  public:
+  TwoWire(DS1307Sim &dev) : begins(0), clock(100000UL), _dev(dev), _txLen(0), _rxLen(0), _rxPos(0) {}
+
+  void begin(void) { begins++; }
+  void begin(int sda, int scl) { (void)sda; (void)scl; begins++; }
+  void setClock(uint32_t hz) { clock = hz; }
+
+  void beginTransmission(uint8_t addr) { _addr = addr; _txLen = 0; }
+  size_t write(uint8_t v);
+  uint8_t endTransmission(bool stop = true);
+  uint8_t requestFrom(uint8_t addr, int len);
+  int available(void) { return(_rxLen - _rxPos); }
+  int read(void) { return(_rxPos < _rxLen ? _rxBuf[_rxPos++] : -1); }
+
+  DS1307Sim &device(void) { return(_dev); }
+
+  uint16_t begins;    // calls to begin()
+  uint32_t clock;     // last setClock() frequency
+
+  private:
+  DS1307Sim &_dev;
+  uint8_t _addr;
+  uint8_t _txBuf[BUFFER_LENGTH];
+  uint8_t _txLen;
+  uint8_t _rxBuf[BUFFER_LENGTH];
+  uint8_t _rxLen, _rxPos;
+};
+
+extern DS1307Sim WireDevice;  // the DS1307 on the default bus
+extern TwoWire Wire;
+
+#endif
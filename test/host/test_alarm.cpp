@@ -0,0 +1,147 @@
+/*
+  Host test of the MD_DS1307Alarm scheduler: the order alarms fire in for 
+  one-shot, interval, daily and weekly alarms, cancelling, and the heap 
+  order under a mix of adds and cancels.
+ */
+#include <MD_DS1307.h>
+#include <MD_DS1307_Alarm.h>
+#include "check.h"
+
+#define T(d, h, m, s) (MD_DS1307::makeTime(2024, 1, d, h, m, s))  // 2024-01-01 was a Monday
+
+static MD_DS1307 rtc;
+
+static uint8_t fired[32];
+static uint8_t nFired;
+
+static void record(uint8_t id)
+{
+  if (nFired < sizeof(fired)) fired[nFired] = id;
+  nFired++;
+}
+
+static uint8_t checkAt(MD_DS1307Alarm<8> &alarm, ds1307Time_t t)
+// Set the time and check the alarms, returning the number fired
+{
+  rtc.setTime(t);
+  nFired = 0;
+  return(alarm.check());
+}
+
+static void testKinds(void)
+{
+  MD_DS1307Alarm<8> alarm(rtc);
+  uint8_t every, dailyLate, dailyEarly, weekMon, weekTue, once;
+  ds1307Time_t t = 0;
+
+  rtc.setTime(T(1, 10, 0, 0));
+  every = alarm.every(30, record);          // 10:00:30 and every 30s
+  dailyLate = alarm.daily(10, 1, record);   // 10:01 today
+  dailyEarly = alarm.daily(9, 0, record);   // 09:00 tomorrow
+  weekMon = alarm.weekly(2, 9, 0, record);  // 09:00 next Monday
+  weekTue = alarm.weekly(3, 8, 0, record);  // 08:00 tomorrow
+  once = alarm.at(T(1, 10, 0, 45), record);
+  CHECK_EQ(alarm.getCount(), 6);
+  CHECK(alarm.next(t));
+  CHECK_EQ(t, T(1, 10, 0, 30));
+
+  CHECK_EQ(checkAt(alarm, T(1, 10, 0, 29)), 0);
+  CHECK_EQ(checkAt(alarm, T(1, 10, 0, 30)), 1);
+  CHECK_EQ(fired[0], every);
+  CHECK(alarm.next(t));
+  CHECK_EQ(t, T(1, 10, 0, 45));
+
+  // the one-shot fires and is removed
+  CHECK_EQ(checkAt(alarm, T(1, 10, 0, 50)), 1);
+  CHECK_EQ(fired[0], once);
+  CHECK_EQ(alarm.getCount(), 5);
+  CHECK(!alarm.cancel(once));
+
+  // two due together
+  CHECK_EQ(checkAt(alarm, T(1, 10, 1, 0)), 2);
+  CHECK((fired[0] == every && fired[1] == dailyLate) || (fired[0] == dailyLate && fired[1] == every));
+  CHECK(alarm.cancel(every));
+  CHECK(!alarm.cancel(every));
+  CHECK_EQ(alarm.getCount(), 4);
+
+  // a jump forward fires the alarms passed once each, in time order
+  CHECK_EQ(checkAt(alarm, T(2, 10, 0, 0)), 2);
+  CHECK_EQ(fired[0], weekTue);
+  CHECK_EQ(fired[1], dailyEarly);
+  CHECK(alarm.next(t));
+  CHECK_EQ(t, T(2, 10, 1, 0));
+  CHECK_EQ(checkAt(alarm, T(2, 10, 1, 0)), 1);
+  CHECK_EQ(fired[0], dailyLate);
+
+  // a longer jump fires each repeating alarm passed only once
+  CHECK_EQ(checkAt(alarm, T(8, 9, 30, 0)), 3);
+  CHECK_EQ(fired[0], dailyEarly);   // 3rd 09:00
+  CHECK_EQ(fired[1], dailyLate);    // 3rd 10:01
+  CHECK_EQ(fired[2], weekMon);      // 8th 09:00
+  CHECK(alarm.next(t));
+  CHECK_EQ(t, T(8, 10, 1, 0));
+
+  // freed slots are reused, lowest first
+  CHECK(alarm.cancel(weekMon));
+  CHECK_EQ(alarm.at(T(9, 0, 0, 0), record), every);
+  CHECK_EQ(alarm.at(T(9, 0, 0, 0), record), weekMon);
+  CHECK_EQ(alarm.every(0, record), DS1307_ALARM_NONE);
+  CHECK_EQ(alarm.weekly(8, 0, 0, record), DS1307_ALARM_NONE);
+}
+
+static void testHeap(void)
+// Alarms fire in time order after any mix of adds and cancels
+{
+  MD_DS1307Alarm<8> alarm(rtc);
+  ds1307Time_t due[8];
+  uint32_t seed = 1;
+  uint8_t expect = 0;
+
+  rtc.setTime(T(1, 0, 0, 0));
+  for (uint8_t i = 0; i < 8; i++)
+  {
+    seed = (seed * 1103515245UL) + 12345;
+    due[i] = T(1, 0, 0, 0) + 1 + ((seed >> 8) % 5000);
+    CHECK_EQ(alarm.at(due[i], record), i);
+  }
+  CHECK_EQ(alarm.at(due[0], record), DS1307_ALARM_NONE);
+
+  // cancel from the middle, the end and the top of the heap
+  CHECK(alarm.cancel(3));
+  CHECK(alarm.cancel(7));
+  {
+    ds1307Time_t t = 0;
+    uint8_t top = 0;
+
+    CHECK(alarm.next(t));
+    for (uint8_t i = 0; i < 8; i++)
+      if (due[i] == t) top = i;
+    CHECK(alarm.cancel(top));
+    due[top] = due[3] = due[7] = 0;
+  }
+  for (uint8_t i = 0; i < 8; i++)
+    if (due[i] != 0) expect++;
+  CHECK_EQ(alarm.getCount(), expect);
+
+  // step through the time and check each alarm fires when due
+  nFired = 0;
+  for (ds1307Time_t t = T(1, 0, 0, 0); t <= T(1, 0, 0, 0) + 5001; t++)
+  {
+    uint8_t n = nFired;
+
+    rtc.setTime(t);
+    alarm.check();
+    for (uint8_t i = n; i < nFired; i++)
+      CHECK_EQ(due[fired[i]], t);
+  }
+  CHECK_EQ(nFired, expect);
+  CHECK_EQ(alarm.getCount(), 0);
+}
+
+int main(void)
+{
+  testKinds();
+  testHeap();
+
+  return(CHECK_RESULT());
+}
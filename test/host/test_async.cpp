@@ -0,0 +1,187 @@
+/*
+  Host test of the asynchronous operations run by poll(): the steps and 
+  transactions of chunked RAM transfers and time reads and writes, and the
+  rejection of a new operation while one is running.
+ */
+#include <MD_DS1307.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+static DS1307Sim &dev = WireDevice;
+
+static uint8_t doneOp, doneCount, doneCalls;
+
+static void done(uint8_t op, uint8_t count)
+{
+  doneOp = op;
+  doneCount = count;
+  doneCalls++;
+}
+
+static uint8_t pollAll(MD_DS1307 &rtc)
+// Poll the operation to completion and return the number of polls
+{
+  uint8_t n = 1;
+
+  while (!rtc.poll())
+  {
+    CHECK(rtc.isBusy());
+    if (++n > 20) break;
+  }
+  CHECK(!rtc.isBusy());
+
+  return(n);
+}
+
+static void testRAM(void)
+// RAM transfers in DS1307_ASYNC_CHUNK byte steps, one transaction each
+{
+  MD_DS1307 rtc;
+  uint8_t buf[20], out[20];
+
+  dev.powerUp();
+  rtc.setAsyncCallback(done);
+  for (uint8_t i = 0; i < sizeof(out); i++)
+    out[i] = 0xa0 + i;
+
+  CHECK(!rtc.isBusy());
+  CHECK(!rtc.poll());
+
+  // write: 8 + 8 + 4 bytes
+  dev.resetCounts();
+  doneCalls = 0;
+  CHECK(rtc.beginWriteRAM(40, out, sizeof(out)));
+  CHECK(rtc.isBusy());
+  CHECK_EQ(dev.counts.trans, 0);
+  CHECK(!rtc.poll());
+  CHECK_EQ(dev.counts.trans, 1);
+  CHECK(memcmp(&dev.reg[40], out, 8) == 0);
+  CHECK(dev.reg[48] != out[8]);
+  CHECK_EQ(pollAll(rtc), 2);
+  CHECK_EQ(dev.counts.trans, 3);
+  CHECK_EQ(dev.counts.bytes, (2 + 8) + (2 + 8) + (2 + 4));
+  CHECK(memcmp(&dev.reg[40], out, sizeof(out)) == 0);
+  CHECK_EQ(rtc.getAsyncCount(), sizeof(out));
+  CHECK_EQ(doneCalls, 1);
+  CHECK_EQ(doneOp, DS1307_OP_WRITE_RAM);
+  CHECK_EQ(doneCount, sizeof(out));
+
+  // read: the pointer, then 8 + 8 + 4 bytes
+  dev.resetCounts();
+  memset(buf, 0, sizeof(buf));
+  CHECK(rtc.beginReadRAM(40, buf, sizeof(buf)));
+  CHECK_EQ(pollAll(rtc), 4);
+  CHECK_EQ(dev.counts.trans, 4);
+  CHECK_EQ(dev.counts.bytes, 2 + (1 + 8) + (1 + 8) + (1 + 4));
+  CHECK(memcmp(buf, out, sizeof(buf)) == 0);
+  CHECK_EQ(doneOp, DS1307_OP_READ_RAM);
+  CHECK_EQ(doneCount, sizeof(buf));
+
+  // a failed step ends the operation with the bytes transferred so far
+  memset(buf, 0, sizeof(buf));
+  CHECK(rtc.beginReadRAM(40, buf, sizeof(buf)));
+  CHECK(!rtc.poll());
+  CHECK(!rtc.poll());
+  dev.nack = true;
+  CHECK(rtc.poll());
+  dev.nack = false;
+  CHECK(!rtc.isBusy());
+  CHECK_EQ(rtc.getAsyncCount(), 8);
+  CHECK_EQ(doneCount, 8);
+
+  // bad parameters are rejected
+  CHECK(!rtc.beginWriteRAM(2, out, 4));
+  CHECK(!rtc.beginReadRAM(60, buf, 8));
+  CHECK(!rtc.isBusy());
+}
+
+static void testBusy(void)
+// Only one operation at a time
+{
+  MD_DS1307 rtc;
+  uint8_t buf[16], out[4] = { 1, 2, 3, 4 };
+
+  dev.powerUp();
+  dev.reg[8] = 0x55;
+  CHECK(rtc.beginReadRAM(8, buf, sizeof(buf)));
+  CHECK(!rtc.poll());
+  CHECK(!rtc.beginReadTime());
+  CHECK(!rtc.beginWriteTime());
+  CHECK(!rtc.beginReadRAM(8, buf, 4));
+  CHECK(!rtc.beginWriteRAM(8, out, 4));
+  CHECK_EQ(dev.reg[9], 0);
+  pollAll(rtc);
+  CHECK_EQ(buf[0], 0x55);
+  CHECK_EQ(rtc.getAsyncCount(), sizeof(buf));
+
+  // free again once it completes
+  CHECK(rtc.beginWriteRAM(8, out, 4));
+  pollAll(rtc);
+  CHECK_EQ(dev.reg[9], 2);
+}
+
+static void testTime(void)
+{
+  MD_DS1307 rtc;
+
+  dev.powerUp();
+  rtc.setAsyncCallback(done);
+
+  // partial write with the hour mode unknown: read the mode, then write 
+  // only the minutes and hours
+  dev.reg[0] = 0x80 | 0x42;
+  dev.reg[2] = 0x40 | 0x05;   // 12 hour mode
+  rtc.h = 9; rtc.pm = 1; rtc.m = 30; rtc.s = 0;
+  dev.resetCounts();
+  CHECK(rtc.beginWriteTime(DS1307_FLD_MIN | DS1307_FLD_HOUR));
+  CHECK_EQ(pollAll(rtc), 2);
+  CHECK_EQ(dev.counts.trans, 3);
+  CHECK_EQ(dev.counts.bytes, (2 + 2) + (2 + 2));
+  CHECK_EQ(dev.reg[0], 0x80 | 0x42);
+  CHECK_EQ(dev.reg[1], 0x30);
+  CHECK_EQ(dev.reg[2], 0x40 | 0x20 | 0x09);
+  CHECK_EQ(doneOp, DS1307_OP_WRITE_TIME);
+  CHECK_EQ(doneCount, 2);
+
+  // the mode is now known, so a full write is one step
+  rtc.yyyy = 2024; rtc.mm = 2; rtc.dd = 29; rtc.dow = 5;
+  rtc.h = 11; rtc.pm = 0; rtc.m = 59; rtc.s = 58;
+  dev.resetCounts();
+  CHECK(rtc.beginWriteTime());
+  CHECK_EQ(pollAll(rtc), 1);
+  CHECK_EQ(dev.counts.trans, 1);
+  CHECK_EQ(dev.reg[2], 0x40 | 0x11);
+
+  // read: the pointer, then the time frame
+  rtc.yyyy = rtc.mm = rtc.dd = rtc.h = rtc.m = rtc.s = 0;
+  hostAdvance(3000000UL);
+  dev.resetCounts();
+  CHECK(rtc.beginReadTime());
+  CHECK_EQ(pollAll(rtc), 2);
+  CHECK_EQ(dev.counts.trans, 2);
+  CHECK_EQ(rtc.yyyy, 2024);
+  CHECK_EQ(rtc.dd, 29);
+  CHECK_EQ(rtc.h, 12);
+  CHECK_EQ(rtc.pm, 1);
+  CHECK_EQ(rtc.m, 0);
+  CHECK_EQ(doneOp, DS1307_OP_READ_TIME);
+  CHECK_EQ(doneCount, 7);
+
+  // with the soft clock anchored a read needs no bus traffic
+  rtc.softClock(true, 60);
+  rtc.readTime();
+  dev.resetCounts();
+  CHECK(rtc.beginReadTime());
+  CHECK_EQ(pollAll(rtc), 1);
+  CHECK_EQ(dev.counts.trans, 0);
+  CHECK_EQ(rtc.dd, 29);
+}
+
+int main(void)
+{
+  testRAM();
+  testBusy();
+  testTime();
+
+  return(CHECK_RESULT());
+}
@@ -0,0 +1,112 @@
+/*
+  Host test of the bulk packed time conversions against the single time
+  conversions, with the conversions per second for each.
+ */
+#include <chrono>
+#include <vector>
+#include <MD_DS1307.h>
+#include "check.h"
+
+#define DAYS  36525UL   // 2000 to 2099
+#define COUNT (2 * DAYS)  // two times a day, more than a 16 bit count
+#define LOOPS 20
+
+static std::vector<ds1307Time_t> t(COUNT), t2(COUNT);
+static std::vector<uint16_t> yyyy(COUNT);
+static std::vector<uint8_t> mm(COUNT), dd(COUNT), h(COUNT), m(COUNT), s(COUNT), dow(COUNT);
+
+static const MD_DS1307::timeArray_t f = { yyyy.data(), mm.data(), dd.data(), h.data(), m.data(), s.data(), dow.data() };
+
+static void testBulk(void)
+// Every day from 2000 to 2099 in one call, checked against civilFromDays() and makeTime()
+{
+  MD_DS1307 rtc;
+  uint32_t fails = 0;
+
+  for (uint32_t i = 0; i < COUNT; i++)
+    t[i] = ((i / 2) * 86400UL) + ((i * 7919UL) % 86400UL);
+
+  MD_DS1307::civilFromTimes(t.data(), COUNT, f);
+  MD_DS1307::timesFromCivil(f, COUNT, t2.data());
+
+  for (uint32_t i = 0; i < COUNT; i++)
+  {
+    uint16_t y;
+    uint8_t mo, d;
+
+    MD_DS1307::civilFromDays(t[i] / 86400UL, y, mo, d);
+    if (yyyy[i] != y || mm[i] != mo || dd[i] != d || t2[i] != t[i] ||
+        t[i] != MD_DS1307::makeTime(y, mo, d, h[i], m[i], s[i]) ||
+        dow[i] != rtc.calcDoW(y, mo, d))
+    {
+      if (fails++ < 5)
+        printf("time %u failed\n", (unsigned)i);
+    }
+  }
+  CHECK_EQ(fails, 0);
+}
+
+static double rate(std::chrono::steady_clock::time_point start)
+// Conversions per second since start
+{
+  std::chrono::duration<double> d = std::chrono::steady_clock::now() - start;
+
+  return((double)COUNT * LOOPS / d.count());
+}
+
+static void benchmark(void)
+{
+  std::chrono::steady_clock::time_point start;
+  uint32_t sum = 0;
+
+  start = std::chrono::steady_clock::now();
+  for (uint16_t j = 0; j < LOOPS; j++)
+  {
+    for (uint32_t i = 0; i < COUNT; i++)
+    {
+      uint32_t secs = t[i] % 86400UL;
+
+      MD_DS1307::civilFromDays(t[i] / 86400UL, yyyy[i], mm[i], dd[i]);
+      h[i] = secs / 3600;
+      m[i] = (secs / 60) % 60;
+      s[i] = secs % 60;
+    }
+    sum += yyyy[j];
+  }
+  printf("Single to civil   %.0f per second\n", rate(start));
+
+  start = std::chrono::steady_clock::now();
+  for (uint16_t j = 0; j < LOOPS; j++)
+  {
+    MD_DS1307::civilFromTimes(t.data(), COUNT, f);
+    sum += yyyy[j];
+  }
+  printf("civilFromTimes()  %.0f per second\n", rate(start));
+
+  start = std::chrono::steady_clock::now();
+  for (uint16_t j = 0; j < LOOPS; j++)
+  {
+    for (uint32_t i = 0; i < COUNT; i++)
+      t2[i] = MD_DS1307::makeTime(yyyy[i], mm[i], dd[i], h[i], m[i], s[i]);
+    sum += t2[j];
+  }
+  printf("Single makeTime() %.0f per second\n", rate(start));
+
+  start = std::chrono::steady_clock::now();
+  for (uint16_t j = 0; j < LOOPS; j++)
+  {
+    MD_DS1307::timesFromCivil(f, COUNT, t2.data());
+    sum += t2[j];
+  }
+  printf("timesFromCivil()  %.0f per second\n", rate(start));
+
+  CHECK(sum != 0);    // keep the results in use
+}
+
+int main(void)
+{
+  testBulk();
+  benchmark();
+
+  return(CHECK_RESULT());
+}
@@ -0,0 +1,295 @@
+/*
+  Host test of the simulated DS1307 and of the I2C bus usage of each
+  library call, checked against the library bus statistics.
+ */
+#include <MD_DS1307.h>
+#include <Wire.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+static DS1307Sim &dev = WireDevice;
+
+static void setRegs(uint8_t se, uint8_t mi, uint8_t hr, uint8_t dow, uint8_t dd, uint8_t mo, uint8_t yr)
+{
+  uint8_t r[7] = { se, mi, hr, dow, dd, mo, yr };
+
+  memcpy(dev.reg, r, sizeof(r));
+}
+
+static void testSimulator(void)
+{
+  uint8_t buf[3] = { 0x3f, 0x11, 0x22 };
+  int edges = 0;
+
+  // power up state
+  dev.powerUp();
+  CHECK_EQ(dev.reg[0], 0x80);
+  CHECK_EQ(dev.reg[3], 1);
+  CHECK_EQ(dev.reg[4], 1);
+  CHECK_EQ(dev.reg[5], 1);
+  CHECK_EQ(dev.reg[7], 0x03);
+
+  // halted oscillator does not count
+  hostAdvance(3000000UL);
+  CHECK_EQ(dev.reg[0], 0x80);
+
+  // register pointer wraps from the end of RAM to the seconds
+  CHECK(dev.write(buf, 3));
+  CHECK_EQ(dev.reg[0x3f], 0x11);
+  CHECK_EQ(dev.reg[0], 0x22);
+  CHECK_EQ(dev.read(buf, 2), 2);
+  CHECK_EQ(buf[0], dev.reg[1]);
+  CHECK_EQ(dev.reg[0], 0x22);
+
+  // 24 hour rollover into a new century
+  setRegs(0x59, 0x59, 0x23, 7, 0x31, 0x12, 0x99);
+  hostAdvance(1000000UL);
+  CHECK_EQ(dev.reg[0], 0x00); CHECK_EQ(dev.reg[1], 0x00); CHECK_EQ(dev.reg[2], 0x00);
+  CHECK_EQ(dev.reg[3], 1); CHECK_EQ(dev.reg[4], 0x01); CHECK_EQ(dev.reg[5], 0x01); CHECK_EQ(dev.reg[6], 0x00);
+
+  // 12 hour AM to PM and PM to the next day
+  setRegs(0x59, 0x59, 0x40 | 0x11, 3, 0x28, 0x02, 0x24);
+  hostAdvance(1000000UL);
+  CHECK_EQ(dev.reg[2], 0x40 | 0x20 | 0x12);
+  CHECK_EQ(dev.reg[4], 0x28);
+  dev.reg[2] = 0x40 | 0x20 | 0x11; dev.reg[1] = 0x59; dev.reg[0] = 0x59;
+  hostAdvance(1000000UL);
+  CHECK_EQ(dev.reg[2], 0x40 | 0x12);
+  CHECK_EQ(dev.reg[4], 0x29);   // leap year
+  CHECK_EQ(dev.reg[3], 4);
+
+  // setting CH stops the count
+  dev.reg[0] |= 0x80;
+  hostAdvance(2000000UL);
+  CHECK_EQ(dev.reg[0], 0x80);
+
+  // OUT level with the square wave off
+  dev.reg[0] = 0;
+  dev.reg[7] = 0x80;
+  hostAdvance(1);
+  CHECK(dev.sqwLevel());
+  dev.reg[7] = 0x00;
+  hostAdvance(1);
+  CHECK(!dev.sqwLevel());
+
+  // 1Hz square wave falls at the start of each second
+  buf[0] = 0x00; buf[1] = 0x00;
+  dev.write(buf, 2);    // writing the seconds resets the divider
+  dev.reg[7] = 0x10;
+  dev.attachSQW(0);
+  {
+    static int *count;
+
+    count = &edges;
+    attachInterrupt(0, [] { (*count)++; }, FALLING);
+    hostAdvance(3500000UL);
+    CHECK_EQ(edges, 3);
+    CHECK_EQ(dev.reg[0], 0x03);
+
+    // 4096Hz
+    edges = 0;
+    dev.reg[7] = 0x11;
+    hostAdvance(1000000UL);
+    CHECK_EQ(edges, 4096);
+    detachInterrupt(0);
+  }
+  dev.attachSQW(-1);
+  dev.reg[7] = 0x03;
+}
+
+static void checkOp(MD_DS1307 &rtc, uint8_t op, uint32_t trans, uint32_t bytes)
+// The simulated bus usage matches the expected and the library statistics
+{
+  MD_DS1307::busStats_t st;
+
+  CHECK(rtc.getBusStats(op, st));
+  CHECK_EQ(dev.counts.trans, trans);
+  CHECK_EQ(dev.counts.bytes, bytes);
+  CHECK_EQ(dev.counts.busTime, ((9 * bytes) + (2 * trans)) * SIM_BIT_TIME);
+  CHECK_EQ(st.calls, 1);
+  CHECK_EQ(st.trans, dev.counts.trans);
+  CHECK_EQ(st.bytes, dev.counts.bytes);
+  CHECK_EQ(st.busTime, dev.counts.busTime);
+  rtc.resetBusStats();
+  dev.resetCounts();
+}
+
+static void testCounts(void)
+{
+  MD_DS1307 rtc;
+  uint8_t ram[DS1307_RAM_MAX];
+  uint8_t flags;
+
+  dev.powerUp();
+  memset(ram, 0x5a, sizeof(ram));
+  dev.resetCounts();
+
+  // time, control and 8 byte header in one read
+  flags = rtc.begin(ram, 8);
+  CHECK_EQ(flags, DS1307_BOOT_HALTED);
+  checkOp(rtc, DS1307_OP_BEGIN, 2, 2 + 17);
+
+  rtc.readTime();
+  checkOp(rtc, DS1307_OP_READ_TIME, 2, 2 + 8);
+  CHECK_EQ(rtc.yyyy, 2000);
+  CHECK_EQ(rtc.dd, 1);
+
+  // hour mode is known from the read, so one write
+  rtc.yyyy = 2024; rtc.mm = 2; rtc.dd = 29; rtc.h = 13; rtc.m = 14; rtc.s = 15; rtc.dow = 5;
+  rtc.writeTime();
+  checkOp(rtc, DS1307_OP_WRITE_TIME, 1, 2 + 7);
+  CHECK_EQ(dev.reg[0], 0x15);
+  CHECK_EQ(dev.reg[2], 0x13);
+  CHECK_EQ(dev.reg[6], 0x24);
+
+  // read-modify-write of the control register
+  rtc.control(DS1307_SQW_RUN, DS1307_ON);
+  checkOp(rtc, DS1307_OP_CONTROL, 3, 4 + 3);
+  CHECK_EQ(dev.reg[7], 0x13);
+
+  CHECK_EQ(rtc.status(DS1307_SQW_RUN), DS1307_ON);
+  checkOp(rtc, DS1307_OP_STATUS, 2, 2 + 9);
+
+  // RAM in bus buffer sized chunks
+  CHECK_EQ(rtc.writeRAM(8, ram, 56), 56);
+  checkOp(rtc, DS1307_OP_WRITE_RAM, 2, (31 + 2) + (25 + 2));
+  CHECK_EQ(rtc.readRAM(0, ram, DS1307_RAM_MAX), DS1307_RAM_MAX);
+  checkOp(rtc, DS1307_OP_READ_RAM, 3, 2 + 33 + 33);
+  CHECK_EQ(ram[0x3f], 0x5a);
+
+  // the clock runs with the bus time
+  CHECK_EQ(rtc.readRAM(0, ram, 1), 1);
+  CHECK(ram[0] == 0x15 || ram[0] == 0x16);
+  rtc.resetBusStats();
+
+  // faults are counted
+  {
+    MD_DS1307::busStats_t st;
+
+    dev.nack = true;
+    rtc.readTime();
+    CHECK(rtc.getBusStats(DS1307_OP_READ_TIME, st));
+    CHECK_EQ(st.nacks, 1);
+    CHECK_EQ(st.trans, 1);
+    dev.nack = false;
+
+    dev.shortRead = 3;
+    CHECK_EQ(rtc.readRAM(8, ram, 8), 3);
+    CHECK(rtc.getBusStats(DS1307_OP_READ_RAM, st));
+    CHECK_EQ(st.shortReads, 1);
+  }
+  dev.shortRead = -1;
+}
+
+static void testBegin(void)
+// The bus is only started by begin(), and a long header is read in chunks
+{
+  MD_DS1307 rtc;
+  uint8_t ram[DS1307_RAM_MAX];
+  uint16_t n = Wire.begins;
+
+  dev.powerUp();
+  rtc.readTime();
+  rtc.writeTime();
+  CHECK_EQ(Wire.begins, n);
+
+  rtc.resetBusStats();
+  dev.resetCounts();
+  CHECK_EQ(rtc.begin(ram, 40), DS1307_BOOT_OK);
+  CHECK_EQ(Wire.begins, n + 1);
+  checkOp(rtc, DS1307_OP_BEGIN, 3, 2 + 33 + 17);
+}
+
+static void testBootAnchor(void)
+// begin() anchors the soft clock unless the time is bad, and loads the
+// cache only when the device answered
+{
+  MD_DS1307 rtc;
+  const uint8_t sig[2] = { 'M', 'D' };
+
+  rtc.softClock(true, 60);
+  rtc.enableCache();
+
+  // halted, with no signature, is still a usable time
+  dev.powerUp();
+  CHECK_EQ(rtc.begin(NULL, 2, sig, 2), DS1307_BOOT_HALTED | DS1307_BOOT_BAD_SIG);
+  dev.resetCounts();
+  rtc.readTime();
+  CHECK_EQ(rtc.status(DS1307_CLOCK_HALT), DS1307_ON);
+  CHECK_EQ(dev.counts.trans, 0);
+  CHECK_EQ(rtc.yyyy, 2000);
+
+  // a bad time is not anchored, so the next read goes to the RTC
+  dev.reg[5] = 0x13;
+  CHECK_EQ(rtc.begin(), DS1307_BOOT_HALTED | DS1307_BOOT_BAD_TIME);
+  dev.resetCounts();
+  rtc.readTime();
+  CHECK_EQ(dev.counts.trans, 2);
+
+  // no answer leaves the cache to be loaded by the next status()
+  dev.nack = true;
+  CHECK_EQ(rtc.begin(), DS1307_BOOT_NO_RTC);
+  dev.nack = false;
+  dev.resetCounts();
+  CHECK_EQ(rtc.status(DS1307_SQW_RUN), DS1307_OFF);
+  CHECK_EQ(dev.counts.trans, 2);
+}
+
+static void testAccounting(void)
+// Calls are counted at the public entry point, and the bus use of an 
+// asynchronous operation is only charged to it while it runs
+{
+  MD_DS1307 rtc;
+  MD_DS1307::busStats_t st;
+  uint8_t ram[8];
+  uint32_t trans;
+
+  dev.powerUp();
+  rtc.begin();
+
+  // soft clock reads are counted, though only the first uses the bus
+  rtc.resetBusStats();
+  rtc.softClock(true, 60);
+  rtc.readTime();
+  rtc.readTime();
+  CHECK(rtc.getBusStats(DS1307_OP_READ_TIME, st));
+  CHECK_EQ(st.calls, 2);
+  CHECK_EQ(st.trans, 2);
+  rtc.softClock(false);
+
+  rtc.resetBusStats();
+  dev.resetCounts();
+  CHECK(rtc.beginReadRAM(8, ram, sizeof(ram)));
+  while (!rtc.poll())
+    ;
+  trans = dev.counts.trans;
+  CHECK(rtc.tickBegin(2));
+  rtc.tickEnd();
+  CHECK(rtc.getBusStats(DS1307_OP_READ_RAM, st));
+  CHECK_EQ(st.calls, 1);
+  CHECK_EQ(st.trans, trans);
+}
+
+static void testLibraryObject(void)
+// The library created RTC object is on the Wire bus
+{
+  dev.powerUp();
+  RTC.begin();
+  RTC.yyyy = 2030; RTC.mm = 7; RTC.dd = 4; RTC.dow = 5;
+  RTC.h = 8; RTC.m = 9; RTC.s = 10; RTC.pm = 0;
+  RTC.writeTime();
+  CHECK_EQ(dev.reg[6], 0x30);
+  CHECK_EQ(dev.reg[2], 0x08);
+}
+
+int main(void)
+{
+  testSimulator();
+  testCounts();
+  testBegin();
+  testBootAnchor();
+  testAccounting();
+  testLibraryObject();
+
+  return(CHECK_RESULT());
+}
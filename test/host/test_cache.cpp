@@ -0,0 +1,90 @@
+/*
+  Host test of the control register cache: status() answered from memory,
+  control() writing through without a read, and invalidation, checked 
+  against the simulated bus transactions.
+ */
+#include <MD_DS1307.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+static DS1307Sim &dev = WireDevice;
+
+static void testCache(void)
+{
+  MD_DS1307 rtc;
+  uint32_t hits, misses;
+
+  dev.powerUp();    // halted, control register 0x03
+  rtc.begin();
+  rtc.enableCache();
+  dev.resetCounts();
+
+  // first status() loads the cache, later ones need no bus traffic
+  CHECK_EQ(rtc.status(DS1307_SQW_TYPE_ON), DS1307_SQW_32KHZ);
+  CHECK_EQ(dev.counts.trans, 2);
+  CHECK_EQ(rtc.status(DS1307_CLOCK_HALT), DS1307_ON);
+  CHECK_EQ(rtc.status(DS1307_SQW_TYPE_OFF), DS1307_SQW_LOW);
+  CHECK_EQ(rtc.status<DS1307_12H>(), DS1307_OFF);
+  CHECK_EQ(dev.counts.trans, 2);
+  rtc.getCacheStats(hits, misses);
+  CHECK_EQ(hits, 3);
+  CHECK_EQ(misses, 1);
+
+  // control() of the control register writes without reading it first
+  dev.resetCounts();
+  rtc.control(DS1307_SQW_RUN, DS1307_ON);
+  CHECK_EQ(dev.counts.trans, 1);
+  CHECK_EQ(dev.reg[7], 0x13);
+  CHECK_EQ(rtc.status(DS1307_SQW_RUN), DS1307_ON);
+  CHECK_EQ(dev.counts.trans, 1);
+
+  // writeTime() and readTime() keep the clock halt bit current
+  rtc.yyyy = 2024; rtc.mm = 2; rtc.dd = 29; rtc.h = 13; rtc.m = 14; rtc.s = 15; rtc.dow = 5; rtc.pm = 1;
+  rtc.writeTime();
+  dev.resetCounts();
+  CHECK_EQ(rtc.status(DS1307_CLOCK_HALT), DS1307_OFF);
+  CHECK(rtc.isRunning());
+  CHECK_EQ(dev.counts.trans, 0);
+  dev.reg[0] |= 0x80;   // halted behind the library's back
+  rtc.readTime();
+  dev.resetCounts();
+  CHECK_EQ(rtc.status(DS1307_CLOCK_HALT), DS1307_ON);
+  CHECK_EQ(dev.counts.trans, 0);
+
+  // a change by another bus master is only seen after invalidate() or refresh()
+  dev.reg[7] = 0x80;
+  CHECK_EQ(rtc.status(DS1307_SQW_TYPE_OFF), DS1307_SQW_LOW);
+  rtc.invalidate();
+  CHECK_EQ(rtc.status(DS1307_SQW_TYPE_OFF), DS1307_SQW_HIGH);
+  CHECK_EQ(rtc.status(DS1307_SQW_RUN), DS1307_OFF);
+  CHECK_EQ(dev.counts.trans, 2);
+  dev.reg[7] = 0x10;
+  rtc.refresh();
+  CHECK_EQ(dev.counts.trans, 4);
+  CHECK_EQ(rtc.status(DS1307_SQW_TYPE_ON), DS1307_SQW_1HZ);
+  CHECK_EQ(rtc.status(DS1307_SQW_RUN), DS1307_ON);
+  CHECK_EQ(dev.counts.trans, 4);
+
+  // a failed load is retried on the next call
+  rtc.invalidate();
+  dev.nack = true;
+  rtc.status(DS1307_SQW_RUN);
+  dev.nack = false;
+  CHECK_EQ(rtc.status(DS1307_SQW_RUN), DS1307_ON);
+  rtc.getCacheStats(hits, misses);
+  CHECK_EQ(misses, 4);
+
+  // with the cache off every status() reads the device
+  rtc.enableCache(false);
+  dev.resetCounts();
+  rtc.status(DS1307_SQW_RUN);
+  rtc.status(DS1307_SQW_RUN);
+  CHECK_EQ(dev.counts.trans, 4);
+}
+
+int main(void)
+{
+  testCache();
+
+  return(CHECK_RESULT());
+}
@@ -0,0 +1,172 @@
+/*
+  Host test of the calendar functions over their full ranges. calcDoW() is
+  checked against a day by day count from 1753 to 2199, and the time frame
+  codec round tripped for every date from 2000 to 2099 and every second of
+  the day in both hour modes. Each kernel is then timed in nanoseconds per
+  operation.
+ */
+#include <chrono>
+#include <MD_DS1307.h>
+#include "check.h"
+
+#define LOOPS 1000000UL // iterations for each timing run
+#define MAX_FAIL 10     // failures reported for each check
+
+static MD_DS1307 rtc;
+static volatile uint32_t sink;  // keeps the timed results from being optimised away
+
+static bool isLeap(uint16_t y) { return((y % 4 == 0) && ((y % 100 != 0) || (y % 400 == 0))); }
+
+static uint8_t monthDays(uint16_t y, uint8_t mo)
+{
+  static const uint8_t dim[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+  return(mo == 2 && isLeap(y) ? 29 : dim[mo - 1]);
+}
+
+static uint8_t refBCD(uint8_t v) { return(((v / 10) << 4) | (v % 10)); }
+
+static void fail(uint32_t &count, const char *what, uint32_t v)
+// Count a failure and report the first few of a check
+{
+  if (count++ < MAX_FAIL)
+    printf("%s fail %u\n", what, (unsigned)v);
+}
+
+static void testDoW(void)
+// Count the days from Monday 1 Jan 1753 and compare with calcDoW()
+{
+  uint8_t dow = 2;
+  uint32_t count = 0;
+
+  for (uint16_t y = 1753; y <= 2199; y++)
+    for (uint8_t mo = 1; mo <= 12; mo++)
+      for (uint8_t d = 1; d <= monthDays(y, mo); d++)
+      {
+        if (rtc.calcDoW(y, mo, d) != dow)
+          fail(count, "calcDoW", ((uint32_t)y * 10000UL) + (mo * 100) + d);
+        dow = (dow % 7) + 1;
+      }
+
+  CHECK_EQ(count, 0);
+}
+
+static bool roundTrip(uint16_t y, uint8_t mo, uint8_t d, uint8_t hr, uint8_t mi, uint8_t se, bool mode12)
+// Pack the time, check the frame, unpack it and check the fields
+{
+  uint8_t buf[7], ref[7];
+  uint8_t hr12 = (hr % 12 == 0 ? 12 : hr % 12);
+
+  rtc.yyyy = y; rtc.mm = mo; rtc.dd = d;
+  rtc.m = mi; rtc.s = se;
+  rtc.h = (mode12 ? hr12 : hr);       // 12 hour time is given as h and pm
+  rtc.pm = (mode12 && hr >= 12);
+  rtc.dow = rtc.calcDoW(y, mo, d);
+
+  ref[0] = refBCD(se);
+  ref[1] = refBCD(mi);
+  ref[2] = mode12 ? (0x40 | (hr >= 12 ? 0x20 : 0) | refBCD(hr12)) : refBCD(hr);
+  ref[3] = rtc.dow;
+  ref[4] = refBCD(d);
+  ref[5] = refBCD(mo);
+  ref[6] = refBCD(y - 2000);
+
+  rtc.packTime(buf, mode12);
+  if (memcmp(buf, ref, sizeof(buf)) != 0)
+    return(false);
+
+  rtc.yyyy = rtc.mm = rtc.dd = rtc.h = rtc.m = rtc.s = rtc.pm = 0;
+  rtc.unpackTime(buf);
+
+  return(rtc.yyyy == y && rtc.mm == mo && rtc.dd == d && rtc.m == mi && rtc.s == se &&
+         rtc.h == (mode12 ? hr12 : hr) && (rtc.pm != 0) == (mode12 && hr >= 12) &&
+         rtc.getTime() == MD_DS1307::makeTime(y, mo, d, hr, mi, se));
+}
+
+static void testCodec(void)
+{
+  uint32_t count = 0;
+  uint16_t y = 2000;
+  uint8_t mo = 1, d = 1;
+
+  for (uint8_t mode12 = 0; mode12 < 2; mode12++)
+  {
+    // every date, with the time of day varied
+    for (uint16_t day = 0; day < 36525U; day++)
+    {
+      if (!roundTrip(y, mo, d, day % 24, day % 60, (day / 60) % 60, mode12))
+        fail(count, mode12 ? "12H date" : "24H date", day);
+
+      if (++d > monthDays(y, mo))
+      {
+        d = 1;
+        if (++mo > 12) { mo = 1; y++; }
+      }
+    }
+    y = 2000; mo = 1; d = 1;
+
+    // every second of the day, on a leap day
+    for (uint32_t secs = 0; secs < 86400UL; secs++)
+      if (!roundTrip(2024, 2, 29, secs / 3600, (secs / 60) % 60, secs % 60, mode12))
+        fail(count, mode12 ? "12H time" : "24H time", secs);
+  }
+
+  CHECK_EQ(count, 0);
+}
+
+static void report(const char *label, std::chrono::steady_clock::time_point start)
+// Print the time per operation since start in nanoseconds
+{
+  std::chrono::duration<double, std::nano> t = std::chrono::steady_clock::now() - start;
+
+  printf("%-14s %.2f ns/op\n", label, t.count() / LOOPS);
+}
+
+static void benchmark(void)
+{
+  uint8_t buf[7] = { 0x58, 0x59, 0x71, 0x07, 0x31, 0x12, 0x99 };
+  std::chrono::steady_clock::time_point t;
+  uint16_t y;
+  uint8_t mo, d;
+
+  t = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < LOOPS; i++) sink += rtc.calcDoW(2000 + (i & 63), (i & 7) + 1, (i & 15) + 1);
+  report("calcDoW", t);
+
+  t = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < LOOPS; i++) sink += MD_DS1307::BCD2bin(i & 0x77);
+  report("BCD2bin", t);
+
+  t = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < LOOPS; i++) sink += MD_DS1307::bin2BCD(i % 100);
+  report("bin2BCD", t);
+
+  t = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < LOOPS; i++) { buf[0] = i & 0x37; rtc.unpackTime(buf); sink += rtc.s; }
+  report("unpack", t);
+
+  t = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < LOOPS; i++) { rtc.s = i & 0x1f; rtc.packTime(buf, false); sink += buf[0]; }
+  report("pack 24H", t);
+
+  t = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < LOOPS; i++) { rtc.s = i & 0x1f; rtc.packTime(buf, true); sink += buf[0]; }
+  report("pack 12H", t);
+
+  t = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < LOOPS; i++) { MD_DS1307::civilFromDays((i % 36525U), y, mo, d); sink += d; }
+  report("civilFromDays", t);
+
+  t = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < LOOPS; i++) { rtc.s = i & 0x1f; sink += rtc.getTime(); }
+  report("getTime", t);
+}
+
+int main(void)
+{
+  testDoW();
+  testCodec();
+  benchmark();
+
+  return(CHECK_RESULT());
+}
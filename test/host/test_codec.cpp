@@ -0,0 +1,149 @@
+/*
+  Host test of the time frame codec: BCD conversion, packTime() and 
+  unpackTime() in both hour modes, and the frames written to the RTC.
+ */
+#include <MD_DS1307.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+static DS1307Sim &dev = WireDevice;
+
+static uint8_t refBCD(uint8_t v) { return(((v / 10) << 4) | (v % 10)); }
+
+static void refPack(const MD_DS1307 &rtc, uint8_t *buf, bool mode12)
+// Reference frame, as packed by the per field code up to version 1.3.5
+{
+  buf[0] = refBCD(rtc.s);
+  buf[1] = refBCD(rtc.m);
+  if (mode12)
+  {
+    uint8_t hr = rtc.h;
+    bool isPM = rtc.pm;
+
+    if (hr > 12) { hr -= 12; isPM = true; }
+    else if (hr == 0) hr = 12;    // h 1 to 12 is 12 hour time, with pm
+    buf[2] = refBCD(hr) | 0x40 | (isPM ? 0x20 : 0);
+  }
+  else
+    buf[2] = refBCD(rtc.h);
+  buf[3] = refBCD(rtc.dow);
+  buf[4] = refBCD(rtc.dd);
+  buf[5] = refBCD(rtc.mm);
+  buf[6] = refBCD(rtc.yyyy - 2000);
+}
+
+static void testBCD(void)
+{
+  for (uint8_t v = 0; v < 100; v++)
+  {
+    CHECK_EQ(MD_DS1307::bin2BCD(v), refBCD(v));
+    CHECK_EQ(MD_DS1307::BCD2bin(refBCD(v)), v);
+  }
+}
+
+static void testFrames(void)
+{
+  MD_DS1307 rtc;
+
+  for (uint8_t mode12 = 0; mode12 < 2; mode12++)
+  {
+    for (uint8_t hr = 0; hr < 24; hr++)
+    {
+      uint8_t buf[7], ref[7];
+
+      rtc.yyyy = 2099; rtc.mm = 12; rtc.dd = 31; rtc.dow = 7;
+      rtc.h = hr; rtc.m = 59; rtc.s = 58; rtc.pm = 0;
+      rtc.packTime(buf, mode12);
+      refPack(rtc, ref, mode12);
+      CHECK(memcmp(buf, ref, sizeof(buf)) == 0);
+
+      // unpack gives the hour in the frame mode, and packs to the same frame
+      rtc.unpackTime(buf);
+      if (mode12)
+      {
+        CHECK_EQ(rtc.h, hr % 12 == 0 ? 12 : hr % 12);
+        CHECK_EQ(rtc.pm != 0, hr > 12);   // h 12 with pm clear is 12 am
+      }
+      else
+      {
+        CHECK_EQ(rtc.h, hr);
+        CHECK_EQ(rtc.pm, 0);
+      }
+      CHECK_EQ(rtc.yyyy, 2099);
+      CHECK_EQ(rtc.s, 58);
+      rtc.packTime(ref, mode12);
+      CHECK(memcmp(buf, ref, sizeof(buf)) == 0);
+    }
+  }
+
+  // the CH bit is not part of the seconds
+  {
+    uint8_t buf[7] = { 0x80 | 0x45, 0x30, 0x08, 0x02, 0x15, 0x06, 0x24 };
+
+    rtc.unpackTime(buf);
+    CHECK_EQ(rtc.s, 45);
+    CHECK_EQ(rtc.m, 30);
+    CHECK_EQ(rtc.h, 8);
+    CHECK_EQ(rtc.dd, 15);
+    CHECK_EQ(rtc.mm, 6);
+    CHECK_EQ(rtc.yyyy, 2024);
+  }
+}
+
+static void testDevice(void)
+// Frames written to and read from the simulated RTC in both hour modes
+{
+  MD_DS1307 rtc;
+
+  dev.powerUp();
+  rtc.yyyy = 2024; rtc.mm = 2; rtc.dd = 29; rtc.dow = 5;
+  rtc.h = 13; rtc.m = 5; rtc.s = 9;
+  rtc.writeTime();
+  CHECK_EQ(dev.reg[0], 0x09);   // writing the seconds clears CH
+  CHECK_EQ(dev.reg[2], 0x13);
+
+  // changing the hour mode converts the hour register
+  rtc.control(DS1307_12H, DS1307_ON);
+  CHECK_EQ(dev.reg[2], 0x40 | 0x20 | 0x01);
+  rtc.readTime();
+  CHECK_EQ(rtc.h, 1);
+  CHECK(rtc.pm);
+
+  // 24 hour time is written as 12 hour time in 12 hour mode
+  rtc.h = 0; rtc.pm = 0;
+  rtc.writeTime();
+  CHECK_EQ(dev.reg[2], 0x40 | 0x12);
+  rtc.h = 12; rtc.pm = 1;
+  rtc.writeTime();
+  CHECK_EQ(dev.reg[2], 0x40 | 0x20 | 0x12);
+
+  // pm is an input, kept from the last read unless it is set
+  rtc.h = 15; rtc.pm = 0;
+  rtc.writeTime();
+  rtc.readTime();
+  CHECK_EQ(rtc.h, 3);
+  CHECK(rtc.pm);
+  rtc.h = 9;
+  rtc.writeTime();
+  CHECK_EQ(dev.reg[2], 0x40 | 0x20 | 0x09);
+  rtc.h = 9; rtc.pm = (rtc.h >= 12);
+  rtc.writeTime();
+  CHECK_EQ(dev.reg[2], 0x40 | 0x09);
+  rtc.h = 0; rtc.pm = 0;
+  rtc.writeTime();
+
+  rtc.control(DS1307_12H, DS1307_OFF);
+  CHECK_EQ(dev.reg[2], 0x00);
+  rtc.readTime();
+  CHECK_EQ(rtc.h, 0);
+  CHECK_EQ(rtc.pm, 0);
+}
+
+int main(void)
+{
+  testBCD();
+  testFrames();
+  testDevice();
+
+  return(CHECK_RESULT());
+}
@@ -0,0 +1,144 @@
+/*
+  Host test of control() changes batched by beginControl()/commitControl()
+  and of the compile time control<>() and status<>(), checked against the 
+  simulated device registers and bus transactions.
+ */
+#include <MD_DS1307.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+static DS1307Sim &dev = WireDevice;
+
+static void testBatch(void)
+{
+  MD_DS1307 rtc;
+  MD_DS1307::busStats_t st;
+
+  dev.powerUp();    // control register 0x03
+  rtc.begin();
+  rtc.resetBusStats();
+  dev.resetCounts();
+
+  // three changes to the control register in one read-modify-write
+  rtc.beginControl();
+  rtc.control(DS1307_SQW_TYPE_ON, DS1307_SQW_1HZ);
+  rtc.control(DS1307_SQW_TYPE_OFF, DS1307_SQW_HIGH);
+  rtc.control(DS1307_SQW_RUN, DS1307_ON);
+  rtc.control(DS1307_SQW_TYPE_ON, DS1307_SQW_4KHZ);   // the last change wins
+  CHECK_EQ(dev.counts.trans, 0);
+  CHECK_EQ(dev.reg[7], 0x03);
+  rtc.commitControl();
+  CHECK_EQ(dev.reg[7], 0x91);
+  CHECK_EQ(dev.counts.trans, 3);
+  CHECK_EQ(dev.counts.bytes, 4 + 3);
+  CHECK(rtc.getBusStats(DS1307_OP_CONTROL, st));
+  CHECK_EQ(st.calls, 5);     // the queued calls and the commit
+  CHECK_EQ(st.trans, 3);
+
+  // a change can be undone in the same batch
+  dev.resetCounts();
+  rtc.beginControl();
+  rtc.control(DS1307_SQW_RUN, DS1307_OFF);
+  rtc.control(DS1307_SQW_RUN, DS1307_ON);
+  rtc.commitControl();
+  CHECK_EQ(dev.reg[7], 0x91);
+  CHECK_EQ(dev.counts.trans, 3);
+
+  // one read-modify-write for each register changed
+  dev.reg[0] = 0x80 | 0x30;
+  dev.reg[2] = 0x15;
+  dev.resetCounts();
+  rtc.beginControl();
+  rtc.control(DS1307_CLOCK_HALT, DS1307_OFF);
+  rtc.control(DS1307_12H, DS1307_ON);
+  rtc.control(DS1307_SQW_RUN, DS1307_OFF);
+  rtc.commitControl();
+  CHECK_EQ(dev.counts.trans, 9);
+  CHECK_EQ(dev.reg[0] & 0x80, 0);
+  CHECK_EQ(dev.reg[2], 0x40 | 0x20 | 0x03);
+  CHECK_EQ(dev.reg[7], 0x81);
+
+  // invalid values are not queued, and an empty batch writes nothing
+  dev.resetCounts();
+  rtc.beginControl();
+  rtc.control(DS1307_SQW_TYPE_ON, DS1307_SQW_HIGH);
+  rtc.commitControl();
+  rtc.commitControl();
+  CHECK_EQ(dev.counts.trans, 0);
+  CHECK_EQ(dev.reg[7], 0x81);
+
+  // after the commit control() applies changes immediately
+  rtc.control(DS1307_SQW_RUN, DS1307_ON);
+  CHECK_EQ(dev.counts.trans, 3);
+  CHECK_EQ(dev.reg[7], 0x91);
+}
+
+template <uint8_t item, uint8_t value>
+static void checkTemplate(MD_DS1307 &rtc)
+// control<>() sets the same register value as control(), and status<>()
+// reads it back with a single register read
+{
+  uint8_t v;
+
+  dev.reg[7] = 0x03;
+  rtc.control(item, value);
+  v = dev.reg[7];
+  dev.reg[7] = 0x03;
+  dev.resetCounts();
+  rtc.control<item, value>();
+  CHECK_EQ(dev.reg[7], v);
+  CHECK_EQ(dev.counts.trans, 3);
+
+  dev.resetCounts();
+  CHECK_EQ(rtc.status<item>(), value);
+  CHECK_EQ(dev.counts.trans, 2);
+  CHECK_EQ(dev.counts.bytes, 2 + 2);
+  CHECK_EQ(rtc.status(item), value);
+}
+
+static void testTemplates(void)
+{
+  MD_DS1307 rtc;
+
+  dev.powerUp();
+  rtc.begin();
+
+  checkTemplate<DS1307_SQW_RUN, DS1307_ON>(rtc);
+  checkTemplate<DS1307_SQW_RUN, DS1307_OFF>(rtc);
+  checkTemplate<DS1307_SQW_TYPE_ON, DS1307_SQW_1HZ>(rtc);
+  checkTemplate<DS1307_SQW_TYPE_ON, DS1307_SQW_4KHZ>(rtc);
+  checkTemplate<DS1307_SQW_TYPE_ON, DS1307_SQW_8KHZ>(rtc);
+  checkTemplate<DS1307_SQW_TYPE_ON, DS1307_SQW_32KHZ>(rtc);
+  checkTemplate<DS1307_SQW_TYPE_OFF, DS1307_SQW_HIGH>(rtc);
+  checkTemplate<DS1307_SQW_TYPE_OFF, DS1307_SQW_LOW>(rtc);
+
+  // the clock halt and hour mode are in the time registers
+  dev.reg[0] = 0x80 | 0x12;
+  dev.reg[2] = 0x15;
+  rtc.control<DS1307_CLOCK_HALT, DS1307_OFF>();
+  CHECK_EQ(dev.reg[0], 0x12);
+  dev.resetCounts();
+  CHECK_EQ(rtc.status<DS1307_CLOCK_HALT>(), DS1307_OFF);
+  CHECK_EQ(dev.counts.trans, 2);
+  rtc.control<DS1307_12H, DS1307_ON>();
+  CHECK_EQ(dev.reg[2], 0x40 | 0x20 | 0x03);
+  CHECK_EQ(rtc.status<DS1307_12H>(), DS1307_ON);
+  rtc.control<DS1307_12H, DS1307_OFF>();
+  CHECK_EQ(dev.reg[2], 0x15);
+
+  // the templates go through the cache too
+  rtc.enableCache();
+  rtc.refresh();
+  dev.resetCounts();
+  CHECK_EQ(rtc.status<DS1307_12H>(), DS1307_OFF);
+  CHECK_EQ(rtc.status<DS1307_SQW_TYPE_OFF>(), DS1307_SQW_LOW);
+  CHECK_EQ(dev.counts.trans, 0);
+}
+
+int main(void)
+{
+  testBatch();
+  testTemplates();
+
+  return(CHECK_RESULT());
+}
@@ -0,0 +1,162 @@
+/*
+  Host test of the MD_DS1307Drift calibration against a simulated RTC with 
+  a fast or slow oscillator.
+ */
+#include <MD_DS1307.h>
+#include <MD_DS1307_Drift.h>
+#include <MD_DS1307_Log.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+#define T0  MD_DS1307::makeTime(2024, 1, 1)
+
+static DS1307Sim &dev = WireDevice;
+static uint64_t start;    // host time at T0
+
+static ds1307Time_t trueTime(void) { return(T0 + (ds1307Time_t)((hostMicros64() - start) / 1000000ULL)); }
+
+static int32_t rtcError(MD_DS1307 &rtc)
+// RTC time less the true time, in seconds
+{
+  ds1307Time_t t;
+
+  rtc.readTime(t);
+  return(MD_DS1307::timeDiff(t, trueTime()));
+}
+
+static uint32_t jitter(void)
+// Up to a second, so that corrections fall at any point in the RTC second
+{
+  static uint32_t seed = 12345;
+
+  seed = (seed * 1103515245UL) + 12345;
+  return((seed >> 8) % 1000000UL);
+}
+
+static void run(MD_DS1307 &rtc, MD_DS1307Drift *drift, uint32_t secs, int32_t maxErr)
+// Run for secs seconds, reading the time and updating the drift about every 10 
+// minutes. The RTC error must stay within maxErr seconds.
+{
+  for (uint32_t i = 0; i < secs / 600; i++)
+  {
+    hostAdvance(599500000UL + jitter());
+    if (drift != NULL)
+    {
+      int32_t err;
+
+      rtc.readTime();
+      drift->update();
+      err = rtcError(rtc);
+      if (err > maxErr || err < -maxErr)
+      {
+        CHECK_EQ(err, maxErr);
+        return;
+      }
+    }
+  }
+}
+
+static void setup(MD_DS1307 &rtc, int32_t ppm100)
+{
+  dev.powerUp();
+  dev.drift = ppm100;
+  rtc.setTime(T0);
+  rtc.writeTime();
+  start = hostMicros64();
+}
+
+static void testCalibrate(void)
+{
+  MD_DS1307 rtc;
+  MD_DS1307Drift drift(rtc);
+
+  setup(rtc, 2000);     // 20 ppm fast
+  CHECK(!drift.begin());
+  CHECK_EQ(drift.calibrate(trueTime()), 0);
+  CHECK_EQ(drift.getDrift(), 0);
+
+  // uncorrected, the drift is measured from the error
+  run(rtc, &drift, 4000000UL, 100);
+  CHECK_EQ(drift.calibrate(trueTime()), 80);
+  CHECK(drift.getDrift() > 2000 - 60 && drift.getDrift() < 2000 + 60);
+
+  // corrected, the error stays small and the drift measured is unchanged
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    int32_t err;
+
+    run(rtc, &drift, 4000000UL, 4);
+    err = drift.calibrate(trueTime());
+    CHECK(err >= -3 && err <= 3);
+    CHECK(drift.getDrift() > 2000 - 60 && drift.getDrift() < 2000 + 60);
+  }
+
+  // the calibration is kept in the RTC RAM
+  {
+    MD_DS1307Drift drift2(rtc);
+
+    CHECK(drift2.begin());
+    CHECK_EQ(drift2.getDrift(), drift.getDrift());
+  }
+}
+
+static void testLimit(void)
+// Errors beyond the 30 second correction limit are corrected over several updates
+{
+  MD_DS1307 rtc;
+  MD_DS1307Drift drift(rtc);
+
+  setup(rtc, -30000);   // 300 ppm slow
+  drift.setDrift(-30000);
+  run(rtc, NULL, 400000UL, 0);
+  CHECK(rtcError(rtc) < -110);
+
+  for (uint8_t i = 0; i < 10; i++)
+  {
+    hostAdvance(59500000UL + jitter());
+    rtc.readTime();
+    drift.update();
+  }
+  {
+    int32_t err = rtcError(rtc);
+
+    CHECK(err >= -3 && err <= 3);
+  }
+}
+
+static void testLayout(void)
+// The default log and drift record do not overlap
+{
+  MD_DS1307 rtc;
+  MD_DS1307Drift drift(rtc);
+  MD_DS1307Log log(rtc);
+  uint8_t payload[4] = { 1, 2, 3, 4 };
+
+  setup(rtc, 0);
+  log.begin();
+  for (uint8_t i = 0; i <= log.getCapacity(); i++)
+    CHECK(log.append(T0 + i, payload));
+  drift.setDrift(1234);
+  drift.calibrate(trueTime());
+  for (uint8_t i = 0; i <= log.getCapacity(); i++)
+    CHECK(log.append(T0 + i, payload));
+
+  {
+    MD_DS1307Drift drift2(rtc);
+    MD_DS1307Log log2(rtc);
+
+    CHECK(drift2.begin());
+    CHECK_EQ(drift2.getDrift(), 1234);
+    CHECK(log2.begin());
+    CHECK_EQ(log2.getCount(), log.getCapacity());
+  }
+}
+
+int main(void)
+{
+  testCalibrate();
+  testLimit();
+  testLayout();
+
+  return(CHECK_RESULT());
+}
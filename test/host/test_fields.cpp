@@ -0,0 +1,68 @@
+/*
+  Host test of the DS1307_FLD_* mask of changed interface registers 
+  returned by readTime().
+ */
+#include <MD_DS1307.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+static DS1307Sim &dev = WireDevice;
+
+static void setRegs(uint8_t se, uint8_t mi, uint8_t hr, uint8_t dow, uint8_t dd, uint8_t mo, uint8_t yr)
+{
+  uint8_t r[7] = { se, mi, hr, dow, dd, mo, yr };
+
+  memcpy(dev.reg, r, sizeof(r));
+}
+
+static void testChanged(void)
+{
+  MD_DS1307 rtc;
+
+  dev.powerUp();    // 2000-01-01 00:00:00, halted
+
+  // the date fields change from the constructor values
+  CHECK_EQ(rtc.readTime(), DS1307_FLD_YEAR | DS1307_FLD_MON | DS1307_FLD_DATE | DS1307_FLD_DOW);
+  CHECK_EQ(rtc.readTime(), 0);
+
+  // one second
+  setRegs(0x80 | 0x58, 0x59, 0x23, 7, 0x31, 0x01, 0x00);
+  CHECK_EQ(rtc.readTime(), DS1307_FLD_SEC | DS1307_FLD_MIN | DS1307_FLD_HOUR | DS1307_FLD_DOW | DS1307_FLD_DATE);
+  hostAdvance(1000000UL);
+  CHECK_EQ(rtc.readTime(), 0);   // still halted
+  dev.reg[0] &= ~0x80;
+  hostAdvance(1000000UL);
+  CHECK_EQ(rtc.readTime(), DS1307_FLD_SEC);
+  CHECK_EQ(rtc.s, 59);
+
+  // into the next day and month
+  hostAdvance(1000000UL);
+  CHECK_EQ(rtc.readTime(), DS1307_FLD_SEC | DS1307_FLD_MIN | DS1307_FLD_HOUR | 
+                           DS1307_FLD_DOW | DS1307_FLD_DATE | DS1307_FLD_MON);
+  CHECK_EQ(rtc.mm, 2);
+
+  // into the next year
+  setRegs(0x59, 0x59, 0x23, 1, 0x31, 0x12, 0x00);
+  rtc.readTime();
+  hostAdvance(1000000UL);
+  CHECK_EQ(rtc.readTime(), DS1307_FLD_SEC | DS1307_FLD_MIN | DS1307_FLD_HOUR | 
+                           DS1307_FLD_DOW | DS1307_FLD_DATE | DS1307_FLD_MON | DS1307_FLD_YEAR);
+  CHECK_EQ(rtc.yyyy, 2001);
+
+  // 12 hour mode, AM to PM changes the pm field
+  setRegs(0x59, 0x59, 0x40 | 0x11, 2, 0x01, 0x01, 0x01);
+  rtc.readTime();
+  hostAdvance(1000000UL);
+  CHECK_EQ(rtc.readTime(), DS1307_FLD_SEC | DS1307_FLD_MIN | DS1307_FLD_HOUR | DS1307_FLD_PM);
+  CHECK_EQ(rtc.pm, 1);
+  hostAdvance(3600000000UL);
+  CHECK_EQ(rtc.readTime(), DS1307_FLD_HOUR);
+  CHECK_EQ(rtc.h, 1);
+}
+
+int main(void)
+{
+  testChanged();
+
+  return(CHECK_RESULT());
+}
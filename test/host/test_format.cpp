@@ -0,0 +1,95 @@
+/*
+  Host test of the text conversions format(), parseISO() and parseBuild().
+ */
+#include <MD_DS1307.h>
+#include "check.h"
+
+static MD_DS1307 rtc;
+
+static void checkISO(const char *iso)
+// Parse the ISO text, format it again and compare
+{
+  char buf[DS1307_FMT_LEN];
+
+  CHECK(rtc.parseISO(iso));
+  CHECK_EQ(rtc.format(buf, sizeof(buf)), strlen(iso));
+  CHECK(strcmp(buf, iso) == 0);
+}
+
+static void checkFormat(const char *fmt, const char *expect)
+{
+  char buf[40];
+
+  CHECK_EQ(rtc.format(buf, sizeof(buf), fmt), strlen(expect));
+  if (strcmp(buf, expect) != 0)
+    printf("format \"%s\" gave \"%s\", expected \"%s\"\n", fmt, buf, expect);
+  CHECK(strcmp(buf, expect) == 0);
+}
+
+static void testParse(void)
+{
+  static const char *bad[] =
+  { 
+    "2023-02-29T00:00:00", "2024-13-01T00:00:00", "2024-01-01T24:00:00", "2024-01-01X00:00:00", 
+    "2024-1-01T00:00:00", "1999-12-31T23:59:59", "2100-01-01T00:00:00", "2024-01-01T00:60:00", ""
+  };
+
+  checkISO("2000-01-01T00:00:00");
+  checkISO("2024-02-29T12:00:00");
+  checkISO("2099-12-31T23:59:59");
+
+  // the date and time may be separated by a space
+  CHECK(rtc.parseISO("2024-06-15 08:09:10"));
+  CHECK_EQ(rtc.getTime(), MD_DS1307::makeTime(2024, 6, 15, 8, 9, 10));
+  CHECK_EQ(rtc.dow, rtc.calcDoW(2024, 6, 15));
+
+  // bad text leaves the registers unchanged
+  for (uint8_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+  {
+    CHECK(!rtc.parseISO(bad[i]));
+    CHECK_EQ(rtc.getTime(), MD_DS1307::makeTime(2024, 6, 15, 8, 9, 10));
+  }
+
+  CHECK(rtc.parseBuild("Mar  5 2031", "07:08:09"));
+  CHECK_EQ(rtc.getTime(), MD_DS1307::makeTime(2031, 3, 5, 7, 8, 9));
+  CHECK(rtc.parseBuild("Dec 31 2099", "23:59:59"));
+  CHECK_EQ(rtc.getTime(), MD_DS1307::makeTime(2099, 12, 31, 23, 59, 59));
+  CHECK(!rtc.parseBuild("Foo  5 2031", "07:08:09"));
+  CHECK(!rtc.parseBuild("Feb 30 2031", "07:08:09"));
+  CHECK(!rtc.parseBuild("Mar  5 2031", "7:08:09"));
+}
+
+static void testFormat(void)
+{
+  char buf[DS1307_FMT_LEN];
+
+  CHECK(rtc.parseISO("2024-02-29T00:05:09"));
+  checkFormat(DS1307_FMT_TIME12, "12:05:09 am");
+  checkFormat(DS1307_FMT_DATE, "2024-02-29");
+  checkFormat(DS1307_FMT_TIME, "00:05:09");
+  checkFormat("%a %d %b %y", "Thu 29 Feb 24");
+  checkFormat("100%% at %H%M", "100% at 0005");
+
+  CHECK(rtc.parseISO("2024-02-29T12:30:00"));
+  checkFormat(DS1307_FMT_TIME12, "12:30:00 pm");
+  CHECK(rtc.parseISO("2024-02-29T23:30:00"));
+  checkFormat("%I%p", "11pm");
+
+  // pattern in program memory
+  CHECK_EQ(rtc.format(buf, sizeof(buf), F("%H:%M")), 5);
+  CHECK(strcmp(buf, "23:30") == 0);
+
+  // output is cut to fit the buffer and nul terminated
+  CHECK_EQ(rtc.format(buf, 8), 7);
+  CHECK(strcmp(buf, "2024-02") == 0);
+  CHECK_EQ(rtc.format(buf, 1), 0);
+  CHECK_EQ(buf[0], '\0');
+}
+
+int main(void)
+{
+  testParse();
+  testFormat();
+
+  return(CHECK_RESULT());
+}
@@ -0,0 +1,124 @@
+/*
+  Host test of the MD_DS1307Log event log in the simulated RTC RAM.
+ */
+#include <MD_DS1307.h>
+#include <MD_DS1307_Log.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+static DS1307Sim &dev = WireDevice;
+
+static uint8_t seen;
+static ds1307Time_t seenTime[8];
+
+static void collect(ds1307Time_t t, const uint8_t *payload)
+{
+  (void)payload;
+  if (seen < 8) seenTime[seen] = t;
+  seen++;
+}
+
+static void append(MD_DS1307Log &log, ds1307Time_t t)
+{
+  uint8_t payload[4] = { (uint8_t)t, 0, 0, 0 };
+
+  CHECK(log.append(t, payload));
+}
+
+static void checkLog(MD_DS1307Log &log, ds1307Time_t first, uint8_t count)
+// The log holds count records stamped first, first+1, ...
+{
+  ds1307Time_t t = 0;
+  uint8_t payload[4];
+
+  CHECK_EQ(log.getCount(), count);
+  for (uint8_t i = 0; i < count; i++)
+  {
+    CHECK(log.read(i, t, payload));
+    CHECK_EQ(t, first + i);
+    CHECK_EQ(payload[0], (uint8_t)(first + i));
+  }
+
+  seen = 0;
+  CHECK_EQ(log.forEach(collect), count);
+  CHECK_EQ(seen, count);
+  for (uint8_t i = 0; i < count && i < 8; i++)
+    CHECK_EQ(seenTime[i], first + i);
+}
+
+static void testLog(void)
+{
+  MD_DS1307 rtc;
+  MD_DS1307Log log(rtc);
+  uint8_t payload[4] = { 0 };
+  uint8_t cap;
+
+  dev.powerUp();
+  CHECK(!log.begin());
+  cap = log.getCapacity();
+  CHECK(cap > 2);
+  checkLog(log, 0, 0);
+
+  // wraps round, keeping the newest records
+  for (ds1307Time_t t = 1000; t < 1000U + (2 * cap) + 1; t++)
+    append(log, t);
+  checkLog(log, 1000 + cap + 1, cap);
+
+  // the log is found again after a restart
+  {
+    MD_DS1307Log log2(rtc);
+
+    CHECK(log2.begin());
+    checkLog(log2, 1000 + cap + 1, cap);
+  }
+
+  // power failure after the record write leaves the full log intact
+  dev.failAfter = 1;
+  CHECK(!log.append(5000, payload));
+  dev.failAfter = -1;
+  dev.nack = false;
+  {
+    MD_DS1307Log log2(rtc);
+
+    CHECK(log2.begin());
+    checkLog(log2, 1000 + cap + 1, cap);
+  }
+
+  // a damaged record is not returned
+  dev.reg[8 + 4 + (log.getCapacity() * log.RECORD_SIZE) - 2] ^= 0x01;
+  {
+    MD_DS1307Log log2(rtc);
+    ds1307Time_t t;
+
+    CHECK(log2.begin());
+    CHECK_EQ(log2.getCount(), cap);
+    seen = 0;
+    CHECK_EQ(log2.forEach(collect), cap - 1);
+    CHECK_EQ(seen, cap - 1);
+    CHECK_EQ(log2.read(cap - 2, t, payload) + log2.read(cap - 1, t, payload), 1);
+  }
+
+  // a damaged header clears the log
+  dev.reg[8 + 1] ^= 0x01;
+  {
+    MD_DS1307Log log2(rtc);
+
+    CHECK(!log2.begin());
+    CHECK_EQ(log2.getCount(), 0);
+  }
+
+  // too small a region has no capacity
+  {
+    MD_DS1307Log log2(rtc, 8, 4 + (2 * MD_DS1307Log::RECORD_SIZE) - 1);
+
+    CHECK_EQ(log2.getCapacity(), 0);
+    CHECK(!log2.append(1, payload));
+  }
+}
+
+int main(void)
+{
+  testLog();
+
+  return(CHECK_RESULT());
+}
@@ -0,0 +1,60 @@
+/*
+  Host test of the MD_DS1307NVRAM write-back cache in the simulated RTC RAM.
+ */
+#include <MD_DS1307.h>
+#include <MD_DS1307_NVRAM.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+static DS1307Sim &dev = WireDevice;
+
+static void testFlush(void)
+// Dirty runs are written in one burst each, clean bytes are left alone
+{
+  MD_DS1307 rtc;
+  MD_DS1307NVRAM nv(rtc);
+  uint8_t v = 0x11, other = 0x77;
+  uint8_t run[3] = { 1, 2, 3 };
+
+  dev.powerUp();
+  CHECK(nv.begin());
+
+  // a byte written behind the cache between two dirty bytes
+  CHECK_EQ(rtc.writeRAM(11, &other, 1), 1);
+  CHECK_EQ(nv.write(10, &v, 1), 1);
+  CHECK_EQ(nv.write(12, &v, 1), 1);
+  CHECK_EQ(nv.getDirtyCount(), 2);
+  dev.resetCounts();
+  CHECK_EQ(nv.flush(), 2);
+  CHECK_EQ(dev.counts.trans, 2);
+  CHECK_EQ(dev.reg[10], 0x11);
+  CHECK_EQ(dev.reg[11], 0x77);
+  CHECK_EQ(dev.reg[12], 0x11);
+  CHECK_EQ(nv.getDirtyCount(), 0);
+
+  // neighbouring dirty bytes go in one burst, unchanged bytes are not dirty
+  CHECK_EQ(nv.write(20, run, 3), 3);
+  CHECK_EQ(nv.write(21, run + 1, 1), 1);
+  CHECK_EQ(nv.getDirtyCount(), 3);
+  dev.resetCounts();
+  CHECK_EQ(nv.flush(), 1);
+  CHECK_EQ(dev.counts.trans, 1);
+  CHECK(memcmp(&dev.reg[20], run, 3) == 0);
+  CHECK_EQ(nv.flush(), 0);
+
+  // a failed write leaves the bytes dirty
+  CHECK_EQ(nv.write(30, &v, 1), 1);
+  dev.nack = true;
+  CHECK_EQ(nv.flush(), 0);
+  CHECK_EQ(nv.getDirtyCount(), 1);
+  dev.nack = false;
+  CHECK_EQ(nv.flush(), 1);
+  CHECK_EQ(dev.reg[30], 0x11);
+}
+
+int main(void)
+{
+  testFlush();
+
+  return(CHECK_RESULT());
+}
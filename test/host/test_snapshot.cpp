@@ -0,0 +1,80 @@
+/*
+  Host test of the interrupt safe time snapshot: publish() and get() from 
+  an interrupt handler, and the sequence count wrap.
+ */
+#include <MD_DS1307.h>
+#include <MD_DS1307_Snapshot.h>
+#include "check.h"
+
+#define INTR  0
+
+static MD_DS1307 rtc;
+static MD_DS1307Snapshot snapshot(rtc);
+static MD_DS1307Snapshot::snapshot_t isrSnap;
+static bool isrOk;
+
+static void setFields(uint8_t k)
+// Set every interface register from k, so that a mixed copy can be seen
+{
+  rtc.yyyy = 2000 + k;
+  rtc.mm = rtc.dd = rtc.h = rtc.m = rtc.s = rtc.dow = k;
+  rtc.pm = k & 1;
+}
+
+static bool consistent(const MD_DS1307Snapshot::snapshot_t &snap, uint8_t &k)
+{
+  k = snap.mm;
+  return(snap.yyyy == 2000 + k && snap.dd == k && snap.h == k && snap.m == k && 
+         snap.s == k && snap.dow == k && snap.pm == (k & 1));
+}
+
+static void isr(void)
+{
+  isrOk = snapshot.get(isrSnap);
+}
+
+static void testPublish(void)
+{
+  uint8_t k;
+
+  attachInterrupt(INTR, isr, FALLING);
+
+  // nothing published yet
+  setFields(5);
+  hostInterrupt(INTR);
+  CHECK(!isrOk);
+
+  snapshot.publish();
+  hostInterrupt(INTR);
+  CHECK(isrOk);
+  CHECK(consistent(isrSnap, k));
+  CHECK_EQ(k, 5);
+
+  // changing the interface registers does not change the published time
+  setFields(6);
+  hostInterrupt(INTR);
+  CHECK_EQ(isrSnap.mm, 5);
+  snapshot.publish();
+  hostInterrupt(INTR);
+  CHECK_EQ(isrSnap.mm, 6);
+
+  // the sequence count wraps without looking unpublished
+  for (uint16_t i = 0; i < 600; i++)
+  {
+    setFields(1 + (i % 12));
+    snapshot.publish();
+    hostInterrupt(INTR);
+    CHECK(isrOk);
+    CHECK(consistent(isrSnap, k));
+    CHECK_EQ(k, 1 + (i % 12));
+  }
+
+  detachInterrupt(INTR);
+}
+
+int main(void)
+{
+  testPublish();
+
+  return(CHECK_RESULT());
+}
@@ -0,0 +1,144 @@
+/*
+  Host test of the soft clock: the time extrapolated from millis() across
+  day, month, year and leap day rollovers, reanchoring by writeTime() and 
+  the resync interval, checked against the simulated DS1307.
+ */
+#include <MD_DS1307.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+static DS1307Sim &dev = WireDevice;
+
+static void setClock(MD_DS1307 &rtc, uint16_t y, uint8_t mo, uint8_t d, uint8_t hr, uint8_t mi, uint8_t se)
+// Write the time, which anchors the soft clock
+{
+  rtc.yyyy = y; rtc.mm = mo; rtc.dd = d;
+  rtc.h = hr; rtc.m = mi; rtc.s = se; rtc.pm = (hr >= 12);
+  rtc.dow = rtc.calcDoW(y, mo, d);
+  rtc.writeTime();
+}
+
+static void checkTime(MD_DS1307 &rtc, uint16_t y, uint8_t mo, uint8_t d, uint8_t hr, uint8_t mi, uint8_t se)
+{
+  CHECK_EQ(rtc.yyyy, y); CHECK_EQ(rtc.mm, mo); CHECK_EQ(rtc.dd, d);
+  CHECK_EQ(rtc.h, hr); CHECK_EQ(rtc.m, mi); CHECK_EQ(rtc.s, se);
+  CHECK_EQ(rtc.dow, rtc.calcDoW(y, mo, d));
+}
+
+static void checkDevice(MD_DS1307 &rtc)
+// The device agrees with the soft clock time
+{
+  MD_DS1307 ref;
+  uint8_t buf[7];
+
+  memcpy(buf, dev.reg, sizeof(buf));
+  ref.unpackTime(buf);
+  CHECK_EQ(ref.getTime(), rtc.getTime());
+}
+
+static void testRollover(void)
+{
+  MD_DS1307 rtc;
+
+  dev.powerUp();
+  rtc.begin();
+  rtc.softClock(true, 3600);
+
+  // leap day
+  setClock(rtc, 2024, 2, 28, 23, 59, 55);
+  dev.resetCounts();
+  hostAdvance(10000000UL);
+  CHECK(rtc.readTime() != 0);
+  CHECK_EQ(dev.counts.trans, 0);
+  checkTime(rtc, 2024, 2, 29, 0, 0, 5);
+  checkDevice(rtc);
+
+  // end of a leap February, and the end of a common one
+  setClock(rtc, 2024, 2, 29, 23, 59, 59);
+  hostAdvance(2000000UL);
+  rtc.readTime();
+  checkTime(rtc, 2024, 3, 1, 0, 0, 1);
+  setClock(rtc, 2023, 2, 28, 23, 59, 58);
+  hostAdvance(3000000UL);
+  rtc.readTime();
+  checkTime(rtc, 2023, 3, 1, 0, 0, 1);
+
+  // end of the year, by more than a day
+  rtc.softClock(true, 100000UL);
+  setClock(rtc, 2023, 12, 31, 23, 0, 0);
+  dev.resetCounts();
+  for (uint8_t i = 0; i < 25; i++)
+    hostAdvance(3600000000UL);
+  hostAdvance(90000000UL);
+  rtc.readTime();
+  CHECK_EQ(dev.counts.trans, 0);
+  checkTime(rtc, 2024, 1, 2, 0, 1, 30);
+  checkDevice(rtc);
+
+  // 12 hour mode, PM into AM of the next day
+  rtc.control(DS1307_12H, DS1307_ON);
+  setClock(rtc, 2024, 6, 30, 23, 59, 59);
+  CHECK_EQ(dev.reg[2], 0x71);
+  hostAdvance(2000000UL);
+  rtc.readTime();
+  checkTime(rtc, 2024, 7, 1, 12, 0, 1);
+  CHECK_EQ(rtc.pm, 0);
+  checkDevice(rtc);
+  rtc.control(DS1307_12H, DS1307_OFF);
+}
+
+static void testAnchor(void)
+{
+  MD_DS1307 rtc;
+
+  dev.powerUp();
+  rtc.begin();
+  rtc.softClock(true, 60);
+  setClock(rtc, 2024, 5, 1, 10, 0, 0);
+
+  // writeTime() reanchors to the new time with no read
+  hostAdvance(5000000UL);
+  setClock(rtc, 2024, 5, 1, 12, 30, 0);
+  dev.resetCounts();
+  hostAdvance(3000000UL);
+  rtc.readTime();
+  CHECK_EQ(dev.counts.trans, 0);
+  checkTime(rtc, 2024, 5, 1, 12, 30, 3);
+
+  // a partial write drops the anchor, so the next call reads the RTC
+  rtc.m = 45;
+  rtc.writeTime(DS1307_FLD_MIN);
+  dev.resetCounts();
+  rtc.readTime();
+  CHECK_EQ(dev.counts.trans, 2);
+  CHECK_EQ(rtc.m, 45);
+  dev.resetCounts();
+  hostAdvance(1000000UL);
+  rtc.readTime();
+  CHECK_EQ(dev.counts.trans, 0);
+
+  // the resync interval, and resync()
+  hostAdvance(60000000UL);
+  rtc.readTime();
+  CHECK_EQ(dev.counts.trans, 2);
+  rtc.resync();
+  CHECK_EQ(dev.counts.trans, 4);
+  checkDevice(rtc);
+
+  // a halted clock is not extrapolated
+  rtc.control(DS1307_CLOCK_HALT, DS1307_ON);
+  rtc.readTime();
+  dev.resetCounts();
+  hostAdvance(5000000UL);
+  CHECK_EQ(rtc.readTime(), 0);
+  CHECK_EQ(dev.counts.trans, 0);
+  checkDevice(rtc);
+}
+
+int main(void)
+{
+  testRollover();
+  testAnchor();
+
+  return(CHECK_RESULT());
+}
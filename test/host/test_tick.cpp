@@ -0,0 +1,93 @@
+/*
+  Host test of the SQW tick and high resolution modes against the simulated
+  DS1307 square wave output.
+ */
+#include <MD_DS1307.h>
+#include "DS1307Sim.h"
+#include "check.h"
+
+#define SQW_PIN 2   // interrupt 0
+
+static DS1307Sim &dev = WireDevice;
+
+static void setClock(MD_DS1307 &rtc)
+{
+  rtc.yyyy = 2024; rtc.mm = 12; rtc.dd = 31; rtc.dow = 3;
+  rtc.h = 23; rtc.m = 59; rtc.s = 50;
+  rtc.writeTime();
+}
+
+static void testTick(void)
+{
+  MD_DS1307 rtc;
+
+  dev.powerUp();
+  dev.attachSQW(digitalPinToInterrupt(SQW_PIN));
+  setClock(rtc);
+
+  CHECK(rtc.tickBegin(SQW_PIN));
+  CHECK_EQ(dev.reg[7], 0x10);
+
+  // seconds are counted from the edges with no bus traffic
+  dev.resetCounts();
+  hostAdvance(12000000UL);
+  CHECK(rtc.tickCheck());
+  rtc.readTime();
+  CHECK_EQ(dev.counts.trans, 0);
+  CHECK_EQ(rtc.yyyy, 2025);
+  CHECK_EQ(rtc.s, 2);
+
+  rtc.tickEnd();
+}
+
+static void testFine(void)
+{
+  MD_DS1307 rtc;
+  uint16_t frac;
+  uint32_t t;
+
+  dev.powerUp();
+  dev.attachSQW(digitalPinToInterrupt(SQW_PIN));
+  setClock(rtc);
+  hostAdvance(300000UL);    // part way into a second
+
+  // the count is zeroed at the next second boundary
+  t = micros();
+  CHECK(rtc.fineBegin(SQW_PIN, DS1307_SQW_4KHZ));
+  CHECK(micros() - t < 1000000UL);
+  CHECK_EQ(dev.reg[7], 0x11);
+
+  hostAdvance(250000UL);
+  rtc.readTimeFine(frac);
+  CHECK_EQ(rtc.s, 51);
+  CHECK(frac > 16384 - 130 && frac < 16384 + 130);    // 1/4 second to within 2ms
+
+  hostAdvance(1000000UL);
+  rtc.readTimeFine(frac);
+  CHECK_EQ(rtc.s, 52);
+  rtc.tickEnd();
+
+  // a halted clock is not waited for
+  rtc.control(DS1307_CLOCK_HALT, DS1307_ON);
+  t = micros();
+  CHECK(rtc.fineBegin(SQW_PIN, DS1307_SQW_4KHZ));
+  CHECK(micros() - t < 10000UL);
+  rtc.tickEnd();
+
+  // no RTC
+  dev.nack = true;
+  t = micros();
+  CHECK(!rtc.fineBegin(SQW_PIN, DS1307_SQW_4KHZ));
+  CHECK(!rtc.tickBegin(SQW_PIN));
+  CHECK(micros() - t < 10000UL);
+  dev.nack = false;
+  dev.attachSQW(-1);
+}
+
+int main(void)
+{
+  testTick();
+  testFine();
+
+  return(CHECK_RESULT());
+}
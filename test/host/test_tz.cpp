@@ -0,0 +1,145 @@
+/*
+  Host test of the MD_DS1307TZ time zone rules: the daylight saving 
+  transitions in both hemispheres and for last week rules, the repeated and
+  skipped local hours in toUTC(), and the rule parser.
+ */
+#include <MD_DS1307.h>
+#include <MD_DS1307_TZ.h>
+#include "check.h"
+
+#define T(y, mo, d, h, m, s) (MD_DS1307::makeTime(y, mo, d, h, m, s))
+
+static MD_DS1307 rtc;
+
+static void checkChange(MD_DS1307TZ &tz, ds1307Time_t utc, bool dstAfter)
+// Daylight saving changes at the UTC time, and the local time jumps by an hour
+{
+  CHECK_EQ(tz.isDST(utc - 1), !dstAfter);
+  CHECK_EQ(tz.isDST(utc), dstAfter);
+  CHECK_EQ((int32_t)(tz.toLocal(utc) - tz.toLocal(utc - 1)), dstAfter ? 3601 : -3599);
+}
+
+static void testNorth(void)
+{
+  MD_DS1307TZ tz(rtc);
+
+  CHECK(tz.setRule("EST5EDT,M3.2.0,M11.1.0"));
+
+  // 2024-03-10 02:00 EST and 2024-11-03 02:00 EDT
+  checkChange(tz, T(2024, 3, 10, 7, 0, 0), true);
+  checkChange(tz, T(2024, 11, 3, 6, 0, 0), false);
+  CHECK_EQ(tz.toLocal(T(2024, 3, 10, 7, 0, 0)), T(2024, 3, 10, 3, 0, 0));
+  CHECK_EQ(tz.toLocal(T(2024, 11, 3, 6, 0, 0)), T(2024, 11, 3, 1, 0, 0));
+  CHECK_EQ(tz.offset(T(2024, 1, 1, 0, 0, 0)), -5 * 3600L);
+  CHECK_EQ(tz.offset(T(2024, 7, 1, 0, 0, 0)), -4 * 3600L);
+
+  // the repeated hour is taken as the earlier, daylight saving, time
+  CHECK_EQ(tz.toUTC(T(2024, 11, 3, 0, 59, 59)), T(2024, 11, 3, 4, 59, 59));
+  CHECK_EQ(tz.toUTC(T(2024, 11, 3, 1, 0, 0)), T(2024, 11, 3, 5, 0, 0));
+  CHECK_EQ(tz.toUTC(T(2024, 11, 3, 1, 30, 0)), T(2024, 11, 3, 5, 30, 0));
+  CHECK_EQ(tz.toUTC(T(2024, 11, 3, 1, 59, 59)), T(2024, 11, 3, 5, 59, 59));
+  CHECK_EQ(tz.toUTC(T(2024, 11, 3, 2, 0, 0)), T(2024, 11, 3, 7, 0, 0));
+
+  // the skipped hour is taken as standard time
+  CHECK_EQ(tz.toUTC(T(2024, 3, 10, 1, 59, 59)), T(2024, 3, 10, 6, 59, 59));
+  CHECK_EQ(tz.toUTC(T(2024, 3, 10, 2, 30, 0)), T(2024, 3, 10, 7, 30, 0));
+  CHECK_EQ(tz.toUTC(T(2024, 3, 10, 3, 0, 0)), T(2024, 3, 10, 7, 0, 0));
+
+  // the cache follows the year, back and forth
+  checkChange(tz, T(2025, 3, 9, 7, 0, 0), true);
+  checkChange(tz, T(2023, 11, 5, 6, 0, 0), false);
+  checkChange(tz, T(2024, 3, 10, 7, 0, 0), true);
+
+  // now() converts the time in the RTC object
+  rtc.yyyy = 2024; rtc.mm = 7; rtc.dd = 4; rtc.h = 16; rtc.m = 0; rtc.s = 0; rtc.pm = 1;
+  CHECK_EQ(tz.now(), T(2024, 7, 4, 12, 0, 0));
+}
+
+static void testSouth(void)
+// Daylight saving over the new year, with an end time rule
+{
+  MD_DS1307TZ tz(rtc);
+
+  CHECK(tz.setRule("AEST-10AEDT,M10.1.0,M4.1.0/3"));
+
+  // 2024-04-07 03:00 AEDT and 2024-10-06 02:00 AEST
+  CHECK(tz.isDST(T(2024, 1, 1, 0, 0, 0)));
+  checkChange(tz, T(2024, 4, 6, 16, 0, 0), false);
+  checkChange(tz, T(2024, 10, 5, 16, 0, 0), true);
+  CHECK(tz.isDST(T(2024, 12, 31, 23, 59, 59)));
+  CHECK_EQ(tz.toLocal(T(2024, 12, 31, 13, 0, 0)), T(2025, 1, 1, 0, 0, 0));
+
+  CHECK_EQ(tz.toUTC(T(2024, 4, 7, 2, 30, 0)), T(2024, 4, 6, 15, 30, 0));
+  CHECK_EQ(tz.toUTC(T(2024, 10, 6, 2, 30, 0)), T(2024, 10, 5, 16, 30, 0));
+}
+
+static void testLastWeek(void)
+// Week 5 is the last week of the month, whether it has 4 or 5 of the day
+{
+  MD_DS1307TZ tz(rtc);
+
+  CHECK(tz.setRule("CET-1CEST,M3.5.0,M10.5.0/3"));
+
+  checkChange(tz, T(2024, 3, 31, 1, 0, 0), true);     // 5 Sundays in March
+  checkChange(tz, T(2024, 10, 27, 1, 0, 0), false);   // 4 Sundays in October
+  checkChange(tz, T(2025, 3, 30, 1, 0, 0), true);
+  checkChange(tz, T(2025, 10, 26, 1, 0, 0), false);
+}
+
+static void testRoundTrip(void)
+// toUTC() undoes toLocal() every 15 minutes of the year, except the second
+// pass of the repeated hour, which is taken as the first
+{
+  MD_DS1307TZ tz(rtc);
+  uint32_t fails = 0;
+
+  CHECK(tz.setRule("EST5EDT,M3.2.0,M11.1.0"));
+  for (ds1307Time_t t = T(2024, 1, 1, 0, 0, 0); t < T(2025, 1, 1, 0, 0, 0); t += 900)
+  {
+    ds1307Time_t u = tz.toUTC(tz.toLocal(t));
+
+    if (u != t && !(t - u == 3600 && tz.isDST(u) && !tz.isDST(t)))
+      fails++;
+  }
+  CHECK_EQ(fails, 0);
+}
+
+static void testParse(void)
+{
+  MD_DS1307TZ tz(rtc);
+
+  // UTC until a rule is set
+  CHECK_EQ(tz.offset(T(2024, 7, 1, 0, 0, 0)), 0);
+  CHECK(!tz.isDST(T(2024, 7, 1, 0, 0, 0)));
+
+  // no daylight saving, and quoted names with minutes
+  CHECK(tz.setRule("JST-9"));
+  CHECK_EQ(tz.offset(T(2024, 7, 1, 0, 0, 0)), 9 * 3600L);
+  CHECK(tz.setRule("<+0530>-5:30"));
+  CHECK_EQ(tz.toLocal(T(2024, 7, 1, 0, 0, 0)), T(2024, 7, 1, 5, 30, 0));
+
+  // an explicit daylight saving offset
+  CHECK(tz.setRule("LHST-10:30LHDT-11,M10.1.0,M4.1.0"));
+  CHECK_EQ(tz.offset(T(2024, 1, 1, 0, 0, 0)), 11 * 3600L);
+  CHECK_EQ(tz.offset(T(2024, 7, 1, 0, 0, 0)), 37800L);
+
+  // invalid rules leave the time zone unchanged
+  CHECK(!tz.setRule(""));
+  CHECK(!tz.setRule("EST"));
+  CHECK(!tz.setRule("EST5EDT,M3.2.0"));
+  CHECK(!tz.setRule("EST5EDT,J60,J300"));
+  CHECK(!tz.setRule("EST5EDT,M13.2.0,M11.1.0"));
+  CHECK(!tz.setRule("EST5EDT,M3.2.0,M11.1.0x"));
+  CHECK_EQ(tz.offset(T(2024, 1, 1, 0, 0, 0)), 11 * 3600L);
+}
+
+int main(void)
+{
+  testNorth();
+  testSouth();
+  testLastWeek();
+  testRoundTrip();
+  testParse();
+
+  return(CHECK_RESULT());
+}